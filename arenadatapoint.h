@@ -0,0 +1,78 @@
+#pragma once
+#include <memory_resource>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "datapoint.h"
+#include "pqheap.h"
+
+/**
+ * A DataPoint whose name lives in memory from a std::pmr::memory_resource
+ * rather than the general heap. DataPoint itself holds a std::string, which
+ * always allocates long names with malloc, so a queue that should take all
+ * of its memory from an arena holds ArenaDataPoints instead.
+ *
+ * The type is allocator-aware: a BasicPQHeap given an arena constructs its
+ * slots, and every element it copies or builds, with that arena. Moving one
+ * ArenaDataPoint into another that uses the same arena just hands over the
+ * name, while moving across arenas copies the characters.
+ */
+struct ArenaDataPoint {
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    std::pmr::string name;
+    double priority = 0;
+
+    ArenaDataPoint() = default;
+    explicit ArenaDataPoint(const allocator_type& allocator)
+        : name(allocator) {}
+    ArenaDataPoint(std::string_view name, double priority, const allocator_type& allocator = {})
+        : name(name, allocator), priority(priority) {}
+    ArenaDataPoint(const DataPoint& point, const allocator_type& allocator = {})
+        : name(std::string_view(point.name), allocator), priority(point.priority) {}
+
+    ArenaDataPoint(const ArenaDataPoint& other) = default;
+    ArenaDataPoint(ArenaDataPoint&& other) = default;
+    ArenaDataPoint(const ArenaDataPoint& other, const allocator_type& allocator)
+        : name(other.name, allocator), priority(other.priority) {}
+    ArenaDataPoint(ArenaDataPoint&& other, const allocator_type& allocator)
+        : name(std::move(other.name), allocator), priority(other.priority) {}
+    ArenaDataPoint& operator=(const ArenaDataPoint& other) = default;
+    ArenaDataPoint& operator=(ArenaDataPoint&& other) = default;
+
+    /**
+     * Returns an ordinary DataPoint with a copy of this name and priority.
+     */
+    DataPoint toDataPoint() const {
+        return { std::string(name), priority };
+    }
+};
+
+inline bool operator==(const ArenaDataPoint& a, const ArenaDataPoint& b) {
+    return a.name == b.name && a.priority == b.priority;
+}
+
+inline bool operator!=(const ArenaDataPoint& a, const ArenaDataPoint& b) {
+    return !(a == b);
+}
+
+inline std::ostream& operator<<(std::ostream& out, const ArenaDataPoint& point) {
+    return out << "{\"" << point.name << "\", " << point.priority << "}";
+}
+
+/**
+ * Key function that reads the priority of an ArenaDataPoint.
+ */
+struct ArenaDataPointPriority {
+    double operator()(const ArenaDataPoint& element) const {
+        return element.priority;
+    }
+};
+
+/**
+ * Priority queue of ArenaDataPoints, smallest priority first. Construct it
+ * with an arena, e.g. ArenaPQHeap pq(&pool), to keep both the array and the
+ * names out of the general heap.
+ */
+using ArenaPQHeap = BasicPQHeap<ArenaDataPoint, std::less<>, ArenaDataPointPriority>;
@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include "testing/MemoryUtils.h"
+
+/**
+ * A std::pmr::memory_resource that passes every request on to another
+ * resource (the general heap by default) and counts them: how many blocks
+ * were allocated, how many bytes they came to, and how many bytes are still
+ * in use. The tests and benchmarks hand one to the structure they measure,
+ * either directly as its arena or by making it the default resource with
+ * CountingScope, so that only that structure's allocations are counted.
+ *
+ * Like std::pmr::unsynchronized_pool_resource, it is meant to be used by one
+ * thread at a time.
+ */
+class CountingResource : public std::pmr::memory_resource {
+public:
+    /**
+     * Creates a resource that allocates from upstream.
+     *
+     * @param upstream The resource that every request is passed on to.
+     */
+    explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : _upstream(upstream) {}
+
+    /**
+     * Returns the number of blocks allocated so far.
+     */
+    long numAllocations() const {
+        return _numAllocations;
+    }
+
+    /**
+     * Returns the total size of every block allocated so far.
+     */
+    long bytesAllocated() const {
+        return _bytesAllocated;
+    }
+
+    /**
+     * Returns the size of the blocks allocated and not yet deallocated.
+     */
+    long bytesInUse() const {
+        return _bytesInUse;
+    }
+
+    /**
+     * Returns the most bytes that have been in use at any one time.
+     */
+    long peakBytesInUse() const {
+        return _peakBytesInUse;
+    }
+
+private:
+    std::pmr::memory_resource* _upstream;
+    long _numAllocations = 0;
+    long _bytesAllocated = 0;
+    long _bytesInUse = 0;
+    long _peakBytesInUse = 0;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        void* block = _upstream->allocate(bytes, alignment);
+        _numAllocations++;
+        _bytesAllocated += long(bytes);
+        _bytesInUse += long(bytes);
+        _peakBytesInUse = std::max(_peakBytesInUse, _bytesInUse);
+        return block;
+    }
+
+    void do_deallocate(void* block, size_t bytes, size_t alignment) override {
+        _upstream->deallocate(block, bytes, alignment);
+        _bytesInUse -= long(bytes);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    DISALLOW_COPYING_OF(CountingResource);
+};
+
+/**
+ * Makes the given resource the default std::pmr resource for as long as the
+ * scope lives, and puts back the previous default when it ends. Structures
+ * built in the scope that allocate from the default resource, such as the
+ * array of a PQHeap or a copy of an ArenaDataPoint, then allocate from the
+ * given resource.
+ */
+class CountingScope {
+public:
+    explicit CountingScope(std::pmr::memory_resource* resource)
+        : _previous(std::pmr::set_default_resource(resource)) {}
+
+    ~CountingScope() {
+        std::pmr::set_default_resource(_previous);
+    }
+
+private:
+    std::pmr::memory_resource* _previous;
+
+    DISALLOW_COPYING_OF(CountingScope);
+};
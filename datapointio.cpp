@@ -0,0 +1,428 @@
+/*
+ * File Synopsis:
+ * This file implements the binary DataPoint file format and the two fast readers declared in
+ * datapointio.h: one that memory-maps a binary file and one that parses the text written by
+ * operator<<. Both hand out DataPointViews whose names point into their own storage, so reading a
+ * point never allocates. The tests for the format and the readers are at the bottom of the file; the
+ * trial that splits topK's time into parsing and queue work is in pqclient.cpp.
+ */
+
+#include "datapointio.h"
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+#if defined(_WIN32)
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+// layout of the binary file
+static const char MAGIC[8] = { 'P', 'Q', 'D', 'A', 'T', 'A', '1', '\n' };
+static const size_t HEADER_SIZE = sizeof(MAGIC) + sizeof(uint64_t);
+static const size_t RECORD_HEADER_SIZE = sizeof(double) + sizeof(uint32_t);
+
+/*
+ * Function Synopsis:
+ * writeDataPointFile writes every point of the vector through a DataPointFileWriter. Nothing is returned.
+ */
+void writeDataPointFile(const string& path, const Vector<DataPoint>& points) {
+    DataPointFileWriter writer(path);
+    for (const DataPoint& dp : points) {
+        writer.write(dp);
+    }
+    writer.close();
+}
+
+/*
+ * The header is written with a count of zero, to be patched by close once the real count is known.
+ * The output goes through one ofstream buffer, so each record costs three small copies and no system
+ * call of its own.
+ */
+DataPointFileWriter::DataPointFileWriter(const string& path) : _out(path, ios::binary | ios::trunc), _path(path) {
+    if (!_out) {
+        error("Cannot open " + path + " for writing");
+    }
+    _count = 0;
+    _out.write(MAGIC, sizeof(MAGIC));
+    _out.write(reinterpret_cast<const char*>(&_count), sizeof(_count));
+}
+
+/*
+ * A writer destroyed without close, e.g. while an error is unwinding the stack, still leaves a
+ * complete file; any failure is ignored because a destructor must not call error().
+ */
+DataPointFileWriter::~DataPointFileWriter() {
+    if (_out.is_open()) {
+        _out.seekp(sizeof(MAGIC));
+        _out.write(reinterpret_cast<const char*>(&_count), sizeof(_count));
+        _out.close();
+    }
+}
+
+void DataPointFileWriter::write(const DataPoint& dp) {
+    uint32_t length = uint32_t(dp.name.size());
+    _out.write(reinterpret_cast<const char*>(&dp.priority), sizeof(dp.priority));
+    _out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    _out.write(dp.name.data(), length);
+    _count++;
+}
+
+void DataPointFileWriter::close() {
+    _out.seekp(sizeof(MAGIC));
+    _out.write(reinterpret_cast<const char*>(&_count), sizeof(_count));
+    _out.close();
+    if (!_out) {
+        error("Cannot write " + _path);
+    }
+}
+
+/*
+ * The constructor maps the whole file read-only and tells the kernel it will be read from front to
+ * back, so pages are read ahead of the cursor. The descriptor is not needed once the mapping exists.
+ * The header is checked here so that next only has to check that each record fits in the file. A
+ * count of more records than the file has room for, even with empty names, is refused before anyone
+ * sizes an array by it.
+ */
+MappedDataPointFile::MappedDataPointFile(const string& path) {
+#if defined(_WIN32)
+    ifstream in(path, ios::binary);
+    if (!in) {
+        error("Cannot open " + path);
+    }
+    _buffer.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    _data = _buffer.data();
+    _length = _buffer.size();
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error("Cannot open " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) < HEADER_SIZE) {
+        close(fd);
+        error(path + " is not a DataPoint file");
+    }
+    _length = size_t(info.st_size);
+    void* mapping = mmap(nullptr, _length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        error("Cannot map " + path);
+    }
+    madvise(mapping, _length, MADV_SEQUENTIAL);
+    _data = static_cast<const char*>(mapping);
+#endif
+    if (_length < HEADER_SIZE || memcmp(_data, MAGIC, sizeof(MAGIC)) != 0) {
+#if !defined(_WIN32)
+        munmap(const_cast<char*>(_data), _length);
+#endif
+        error(path + " is not a DataPoint file");
+    }
+    uint64_t count;
+    memcpy(&count, _data + sizeof(MAGIC), sizeof(count));
+    if (count > (_length - HEADER_SIZE) / RECORD_HEADER_SIZE || count > uint64_t(INT_MAX)) {
+#if !defined(_WIN32)
+        munmap(const_cast<char*>(_data), _length);
+#endif
+        error(path + " claims " + to_string(count) + " records, more than the file can hold");
+    }
+    _count = int(count);
+    rewind();
+}
+
+MappedDataPointFile::~MappedDataPointFile() {
+#if !defined(_WIN32)
+    munmap(const_cast<char*>(_data), _length);
+#endif
+}
+
+DataPointRecords::DataPointRecords() : DataPointRecords(nullptr, nullptr, 0) {}
+
+DataPointRecords::DataPointRecords(const char* begin, const char* end, int count) {
+    _cursor = begin;
+    _end = end;
+    _count = count;
+    _numRead = 0;
+}
+
+/*
+ * Function Synopsis:
+ * next copies the priority and name length out of the record with memcpy, since records are packed
+ * and the priority is usually not aligned, then points the view's name at the bytes that follow.
+ */
+bool DataPointRecords::next(DataPointView& view) {
+    if (_numRead == _count) {
+        return false;
+    }
+    if (size_t(_end - _cursor) < RECORD_HEADER_SIZE) {
+        error("DataPoint file ends inside a record");
+    }
+    uint32_t length;
+    memcpy(&view.priority, _cursor, sizeof(double));
+    memcpy(&length, _cursor + sizeof(double), sizeof(length));
+    _cursor += RECORD_HEADER_SIZE;
+    if (size_t(_end - _cursor) < length) {
+        error("DataPoint file ends inside a record");
+    }
+    view.name = string_view(_cursor, length);
+    _cursor += length;
+    _numRead++;
+    return true;
+}
+
+int DataPointRecords::size() const {
+    return _count;
+}
+
+bool MappedDataPointFile::next(DataPointView& view) {
+    return _records.next(view);
+}
+
+void MappedDataPointFile::rewind() {
+    _records = DataPointRecords(_data + HEADER_SIZE, _data + _length, _count);
+}
+
+int MappedDataPointFile::size() const {
+    return _count;
+}
+
+/*
+ * Function Synopsis:
+ * split hands out runs of count / numParts records, the first count % numParts of them one record
+ * longer. Between the starts of two runs it steps over each record by the length stored in it, so the
+ * names themselves are never touched.
+ */
+vector<DataPointRecords> MappedDataPointFile::split(int numParts) const {
+    if (numParts < 1) {
+        error("Cannot split a DataPoint file into fewer than one part");
+    }
+    vector<DataPointRecords> parts;
+    const char* cursor = _data + HEADER_SIZE;
+    const char* end = _data + _length;
+    for (int part = 0; part < numParts; part++) {
+        int count = _count / numParts + (part < _count % numParts ? 1 : 0);
+        parts.push_back(DataPointRecords(cursor, end, count));
+        for (int i = 0; i < count; i++) {
+            uint32_t length;
+            if (size_t(end - cursor) < RECORD_HEADER_SIZE) {
+                error("DataPoint file ends inside a record");
+            }
+            memcpy(&length, cursor + sizeof(double), sizeof(length));
+            if (size_t(end - cursor) - RECORD_HEADER_SIZE < length) {
+                error("DataPoint file ends inside a record");
+            }
+            cursor += RECORD_HEADER_SIZE + length;
+        }
+    }
+    return parts;
+}
+
+/*
+ * The stream is copied into the buffer through its stream buffer in one go rather than a character
+ * at a time.
+ */
+TextDataPointReader::TextDataPointReader(istream& in) {
+    ostringstream contents;
+    contents << in.rdbuf();
+    _text = contents.str();
+    _pos = 0;
+}
+
+void TextDataPointReader::skipSpace() {
+    while (_pos < _text.size() && isspace(static_cast<unsigned char>(_text[_pos]))) {
+        _pos++;
+    }
+}
+
+void TextDataPointReader::expect(char c) {
+    skipSpace();
+    if (_pos >= _text.size() || _text[_pos] != c) {
+        error("Expected '" + charToString(c) + "' at offset " + integerToString(int(_pos)) + " of DataPoint text");
+    }
+    _pos++;
+}
+
+/*
+ * Function Synopsis:
+ * next parses { "name" , priority } with any whitespace between the parts. The name runs to the next
+ * double quote and is not copied. The priority is read by strtod straight out of the buffer, which
+ * stops at the first character that cannot be part of the number.
+ */
+bool TextDataPointReader::next(DataPointView& view) {
+    skipSpace();
+    if (_pos == _text.size()) {
+        return false;
+    }
+    expect('{');
+    expect('"');
+    size_t close = _text.find('"', _pos);
+    if (close == string::npos) {
+        error("Unterminated name at offset " + integerToString(int(_pos)) + " of DataPoint text");
+    }
+    view.name = string_view(_text).substr(_pos, close - _pos);
+    _pos = close + 1;
+    expect(',');
+    skipSpace();
+    const char* start = _text.c_str() + _pos;
+    char* stop;
+    view.priority = strtod(start, &stop);
+    if (stop == start) {
+        error("Expected a priority at offset " + integerToString(int(_pos)) + " of DataPoint text");
+    }
+    _pos += stop - start;
+    expect('}');
+    return true;
+}
+
+void TextDataPointReader::rewind() {
+    _pos = 0;
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+/* Helper function that gives a path in the temporary directory for a test file. */
+static string tempPath(const string& name) {
+    return (filesystem::temp_directory_path() / name).string();
+}
+
+STUDENT_TEST("MappedDataPointFile: round trip, including empty and long names") {
+    Vector<DataPoint> points = {
+        { "", 0 }, { "R", -4.25 }, { "a name with spaces, a comma and \"quotes\"", 1e300 },
+        { string(1000, 'x'), 7 }, { "last", -0.0 } };
+    string path = tempPath("datapointio-roundtrip.bin");
+    writeDataPointFile(path, points);
+
+    MappedDataPointFile file(path);
+    EXPECT_EQUAL(file.size(), points.size());
+    for (int pass = 0; pass < 2; pass++) {
+        DataPointView view;
+        for (const DataPoint& expected : points) {
+            EXPECT(file.next(view));
+            EXPECT_EQUAL(view.toDataPoint(), expected);
+        }
+        EXPECT(!file.next(view));
+        file.rewind();
+    }
+    remove(path.c_str());
+}
+
+STUDENT_TEST("MappedDataPointFile: empty file of points, missing, foreign and truncated files") {
+    string path = tempPath("datapointio-errors.bin");
+    writeDataPointFile(path, {});
+    {
+        MappedDataPointFile file(path);
+        DataPointView view;
+        EXPECT_EQUAL(file.size(), 0);
+        EXPECT(!file.next(view));
+    }
+
+    writeDataPointFile(path, { { "one", 1 }, { "two", 2 } });
+    string bytes;
+    {
+        ifstream in(path, ios::binary);
+        ostringstream contents;
+        contents << in.rdbuf();
+        bytes = contents.str();
+    }
+    ofstream(path, ios::binary | ios::trunc).write(bytes.data(), bytes.size() - 2);
+    {
+        MappedDataPointFile file(path);
+        DataPointView view;
+        EXPECT(file.next(view));
+        EXPECT_ERROR(file.next(view));
+    }
+
+    for (uint64_t count : { uint64_t(3), uint64_t(INT_MAX) + 1, UINT64_MAX }) {
+        string lying = bytes;
+        memcpy(&lying[8], &count, sizeof(count));
+        ofstream(path, ios::binary | ios::trunc).write(lying.data(), lying.size());
+        EXPECT_ERROR(MappedDataPointFile(path));
+    }
+
+    ofstream(path, ios::trunc) << "{\"not\", 1} {\"binary\", 2}";
+    EXPECT_ERROR(MappedDataPointFile(path));
+    remove(path.c_str());
+    EXPECT_ERROR(MappedDataPointFile(path));
+}
+
+STUDENT_TEST("MappedDataPointFile: split covers every record once, in order") {
+    Vector<DataPoint> points;
+    for (int i = 0; i < 10; i++) {
+        points.add({ string(i, 'n'), double(i) });
+    }
+    string path = tempPath("datapointio-split.bin");
+    writeDataPointFile(path, points);
+    MappedDataPointFile file(path);
+    for (int numParts : { 1, 3, 10, 16 }) {
+        vector<DataPointRecords> parts = file.split(numParts);
+        EXPECT_EQUAL(int(parts.size()), numParts);
+        int next = 0;
+        for (DataPointRecords& part : parts) {
+            EXPECT(part.size() == 10 / numParts || part.size() == 10 / numParts + 1);
+            DataPointView view;
+            while (part.next(view)) {
+                EXPECT_EQUAL(view.toDataPoint(), points[next]);
+                next++;
+            }
+        }
+        EXPECT_EQUAL(next, points.size());
+    }
+    EXPECT_ERROR(file.split(0));
+    remove(path.c_str());
+}
+
+STUDENT_TEST("TextDataPointReader: parses what operator<< writes, as operator>> does") {
+    setRandomSeed(22);
+    Vector<DataPoint> points = { { "", 0 }, { "with space", -1.5 }, { "big", 1e300 } };
+    for (int i = 0; i < 1000; i++) {
+        points.add({ integerToString(randomInteger(0, 100)), randomReal(-1000, 1000) });
+    }
+    stringstream text;
+    for (const DataPoint& dp : points) {
+        text << dp;
+    }
+    stringstream copy(text.str());
+    TextDataPointReader reader(text);
+    DataPointView view;
+    DataPoint expected;
+    while (copy >> expected) {
+        EXPECT(reader.next(view));
+        EXPECT_EQUAL(view.toDataPoint(), expected);
+    }
+    EXPECT(!reader.next(view));
+    reader.rewind();
+    EXPECT(reader.next(view));
+    EXPECT_EQUAL(view.toDataPoint(), points[0]);
+}
+
+STUDENT_TEST("TextDataPointReader: whitespace between parts, errors on malformed text") {
+    stringstream spaced("  {  \"A\" ,\t2.5 }\n{\"B\",-3}  \n");
+    TextDataPointReader reader(spaced);
+    DataPointView view;
+    EXPECT(reader.next(view));
+    EXPECT_EQUAL(view.toDataPoint(), DataPoint({ "A", 2.5 }));
+    EXPECT(reader.next(view));
+    EXPECT_EQUAL(view.toDataPoint(), DataPoint({ "B", -3 }));
+    EXPECT(!reader.next(view));
+
+    for (string bad : { "\"A\", 1}", "{\"A\" 1}", "{\"A\", }", "{\"A\", 1", "{\"A, 1}" }) {
+        stringstream in(bad);
+        TextDataPointReader badReader(in);
+        EXPECT_ERROR(badReader.next(view));
+    }
+}
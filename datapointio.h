@@ -0,0 +1,224 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "vector.h"
+#include "pqinterned.h"   // DataPointView
+
+/*
+ * Readers and writers for streams of DataPoints that skip the cost of
+ * operator>>, which builds a std::string for every name and parses through
+ * the stream's locale, character by character.
+ *
+ * The binary DataPoint file is laid out as follows. Numbers are in the byte
+ * order of the machine that wrote the file.
+ *   header:  the 8 bytes "PQDATA1\n", then the record count as a uint64_t
+ *   record:  the priority as a double, the name length as a uint32_t, then
+ *            that many bytes of name, with no terminator or padding
+ */
+
+/**
+ * Writes the given points to the file at path in the binary DataPoint
+ * format, replacing the file if it exists. If the file cannot be written,
+ * this function calls error().
+ *
+ * @param path The file to write.
+ * @param points The points to write, in order.
+ */
+void writeDataPointFile(const std::string& path, const Vector<DataPoint>& points);
+
+/**
+ * Writes a binary DataPoint file one point at a time, for points that are
+ * never all in memory at once. The count in the header is filled in by close.
+ */
+class DataPointFileWriter {
+public:
+    /**
+     * Creates the file at path, replacing it if it exists. If the file
+     * cannot be opened, this function calls error().
+     *
+     * @param path The file to write.
+     */
+    DataPointFileWriter(const std::string& path);
+
+    /**
+     * Closes the file if close has not been called.
+     */
+    ~DataPointFileWriter();
+
+    /**
+     * Appends one point to the file.
+     *
+     * @param point The point to write.
+     */
+    void write(const DataPoint& point);
+
+    /**
+     * Writes the count into the header and closes the file. If anything could
+     * not be written, this function calls error().
+     */
+    void close();
+
+private:
+    std::ofstream _out;   // the file, open until close
+    std::string _path;    // for error messages
+    uint64_t _count;      // number of points written
+
+    DISALLOW_COPYING_OF(DataPointFileWriter);
+};
+
+/**
+ * A run of consecutive records in a binary DataPoint file that has been
+ * mapped into memory, read one record at a time. A run only points into the
+ * mapping, so copying one is cheap, and separate runs can be read by
+ * separate threads at once.
+ */
+class DataPointRecords {
+public:
+    /**
+     * Creates a run of no records.
+     */
+    DataPointRecords();
+
+    /**
+     * Creates a run of count records that starts at begin and must lie
+     * within [begin, end).
+     *
+     * @param begin The first byte of the first record.
+     * @param end The end of the file.
+     * @param count The number of records in the run.
+     */
+    DataPointRecords(const char* begin, const char* end, int count);
+
+    /**
+     * Reads the next record into view and returns true, or returns false if
+     * every record of the run has been read. If the file ends in the middle
+     * of a record, this function calls error(). This operation runs in
+     * time O(1).
+     *
+     * @param view Receives the next record.
+     * @return Whether a record was read.
+     */
+    bool next(DataPointView& view);
+
+    /**
+     * Returns the number of records in the run.
+     */
+    int size() const;
+
+private:
+    const char* _cursor;  // start of the next record
+    const char* _end;     // end of the file
+    int _count;           // number of records in the run
+    int _numRead;         // number of records read so far
+};
+
+/**
+ * A binary DataPoint file mapped into memory and read one record at a time.
+ * Reading does not copy or allocate: each view's name points straight into
+ * the mapping, so it is valid only as long as the reader is.
+ *
+ * Where memory mapping is not available, the whole file is read into a buffer
+ * instead, and the views point into that buffer.
+ */
+class MappedDataPointFile {
+public:
+    /**
+     * Maps the file at path and checks its header. If the file cannot be
+     * opened, is not a binary DataPoint file, or its header counts more
+     * records than the file could hold, this function calls error().
+     *
+     * @param path The file to read.
+     */
+    MappedDataPointFile(const std::string& path);
+
+    /**
+     * Unmaps the file.
+     */
+    ~MappedDataPointFile();
+
+    /**
+     * Reads the next record into view and returns true, or returns false if
+     * every record has been read. If the file ends in the middle of a record,
+     * this function calls error(). This operation runs in time O(1).
+     *
+     * @param view Receives the next record.
+     * @return Whether a record was read.
+     */
+    bool next(DataPointView& view);
+
+    /**
+     * Goes back to the first record.
+     */
+    void rewind();
+
+    /**
+     * Returns the number of records in the file, as given in its header.
+     */
+    int size() const;
+
+    /**
+     * Splits the records of the file into numParts runs of consecutive
+     * records, as equal in size as possible, for reading in parallel. Finding
+     * where each run starts means stepping over every record once by its
+     * length, so this operation runs in time O(n) but reads no names.
+     * If numParts is less than one, this function calls error().
+     *
+     * @param numParts The number of runs.
+     * @return The runs, in file order.
+     */
+    std::vector<DataPointRecords> split(int numParts) const;
+
+private:
+    const char* _data;    // start of the mapping (or buffer)
+    size_t _length;       // length of the file in bytes
+    int _count;           // number of records, from the header
+    DataPointRecords _records; // the records not yet read by next
+    std::string _buffer;  // the file's contents where it could not be mapped
+
+    DISALLOW_COPYING_OF(MappedDataPointFile);
+};
+
+/**
+ * A fast parser for DataPoints written as text by operator<<, such as
+ * {"name", 3.5}. The rest of the stream is read into a buffer once, and each
+ * view's name points into that buffer. Names may not contain a double quote.
+ */
+class TextDataPointReader {
+public:
+    /**
+     * Reads everything left in the stream into the reader's buffer.
+     *
+     * @param in The stream to read from.
+     */
+    TextDataPointReader(std::istream& in);
+
+    /**
+     * Parses the next DataPoint into view and returns true, or returns false
+     * if only whitespace is left. If the text is not a DataPoint, this
+     * function calls error(). This operation runs in time O(length).
+     *
+     * @param view Receives the next DataPoint.
+     * @return Whether a DataPoint was read.
+     */
+    bool next(DataPointView& view);
+
+    /**
+     * Goes back to the first DataPoint.
+     */
+    void rewind();
+
+private:
+    std::string _text;  // the whole input
+    size_t _pos;        // where parsing resumes
+
+    void skipSpace();
+    void expect(char c);  // skips whitespace, then calls error() unless c is next
+
+    DISALLOW_COPYING_OF(TextDataPointReader);
+};
@@ -0,0 +1,99 @@
+/*
+ * File Synopsis:
+ * This file implements the table of interned names used by InternedPQHeap. Each distinct name is kept
+ * once in a deque, which never moves its elements, so the hash table can map views of those strings to
+ * their ids and a lookup never has to build a std::string. The tests for the table are at the bottom.
+ */
+
+#include "nametable.h"
+#include "error.h"
+#include "strlib.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/*
+ * Function Synopsis:
+ * intern returns the id of its parameter. A name seen for the first time is copied into the deque and
+ * the view of that copy, not of the parameter, is the key added to the hash table.
+ */
+int NameTable::intern(string_view name) {
+    auto found = _ids.find(name);
+    if (found != _ids.end()) {
+        return found->second;
+    }
+    int id = int(_names.size());
+    _names.emplace_back(name);
+    _ids.emplace(string_view(_names.back()), id);
+    return id;
+}
+
+/*
+ * Function Synopsis:
+ * nameOf returns a view of the name with the given id, and calls error() for an id the table never
+ * handed out.
+ */
+string_view NameTable::nameOf(int id) const {
+    if (!isValidId(id)) {
+        error("No name with id " + integerToString(id));
+    }
+    return _names[id];
+}
+
+bool NameTable::isValidId(int id) const {
+    return id >= 0 && id < size();
+}
+
+int NameTable::size() const {
+    return int(_names.size());
+}
+
+/*
+ * Function Synopsis:
+ * bytesUsed adds up the strings in the deque, the characters of any name too long to fit in a string's
+ * own small buffer, one hash node per name and the bucket array. The small buffer's size is that of an
+ * empty string's capacity, which is portable, where sizeof(string) is not: on libstdc++ it is 32 bytes
+ * but holds only 15 characters. The node size is an estimate since it depends on the standard library.
+ */
+long NameTable::bytesUsed() const {
+    static const size_t inlineCapacity = string().capacity(); // the small string buffer
+    long bytes = long(_names.size()) * long(sizeof(string));
+    for (const string& name : _names) {
+        if (name.capacity() > inlineCapacity) {
+            bytes += long(name.capacity()) + 1;
+        }
+    }
+    long nodeSize = sizeof(void*) + sizeof(size_t) + sizeof(pair<const string_view, int>);
+    bytes += long(_ids.size()) * nodeSize + long(_ids.bucket_count()) * long(sizeof(void*));
+    return bytes;
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("NameTable: repeated names share one id, views stay valid as the table grows") {
+    NameTable table;
+    int host = table.intern("host-17.example.com");
+    EXPECT_EQUAL(host, 0);
+    EXPECT_EQUAL(table.intern("batch"), 1);
+    EXPECT_EQUAL(table.intern(string("host-17.example.com")), host);
+    EXPECT_EQUAL(table.size(), 2);
+
+    string_view first = table.nameOf(host);
+    for (int i = 0; i < 1000; i++) {
+        table.intern("job class " + integerToString(i % 100));
+    }
+    EXPECT_EQUAL(table.size(), 102);
+    EXPECT_EQUAL(first, "host-17.example.com");
+    EXPECT_EQUAL(table.nameOf(table.intern("job class 42")), "job class 42");
+    EXPECT(table.bytesUsed() > 102 * long(sizeof(string)));
+
+    NameTable shortName;
+    NameTable mediumName;   // too long for the small string buffer, shorter than sizeof(string)
+    shortName.intern("host");
+    mediumName.intern("host-17.example.co");
+    EXPECT(mediumName.bytesUsed() >= shortName.bytesUsed() + 19);
+
+    EXPECT(!table.isValidId(-1));
+    EXPECT(!table.isValidId(table.size()));
+    EXPECT_ERROR(table.nameOf(table.size()));
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "testing/MemoryUtils.h"
+
+/**
+ * A table of interned names. Every distinct name is stored once and given a
+ * small integer id (0, 1, 2, ... in the order names are first seen), so a
+ * queue can hold the id in place of a std::string. Many queues can share one
+ * table; the table must outlive every queue that uses it.
+ *
+ * Names are never removed, so an id stays valid for the life of the table
+ * and the view returned by nameOf stays valid too.
+ */
+class NameTable {
+public:
+    /**
+     * Creates a new, empty table.
+     */
+    NameTable() = default;
+
+    /**
+     * Returns the id of the given name, adding the name to the table first if
+     * it is not there yet. Looking up a name that is already in the table
+     * does not allocate. This operation runs in expected time O(length).
+     *
+     * @param name The name to look up.
+     * @return The id of the name.
+     */
+    int intern(std::string_view name);
+
+    /**
+     * Returns the name with the given id. The view refers to the copy held
+     * by the table. If id is not an id from this table, this function calls
+     * error().
+     *
+     * This operation runs in time O(1).
+     *
+     * @param id The id of the name.
+     * @return The name.
+     */
+    std::string_view nameOf(int id) const;
+
+    /**
+     * Returns whether id is an id handed out by this table.
+     */
+    bool isValidId(int id) const;
+
+    /**
+     * Returns the number of distinct names in the table.
+     */
+    int size() const;
+
+    /**
+     * Returns an estimate of the bytes of memory the table uses: the strings,
+     * their characters when too long for the small string buffer, and the
+     * nodes and buckets of the hash table.
+     *
+     * @return The approximate size of the table in bytes.
+     */
+    long bytesUsed() const;
+
+private:
+    std::deque<std::string> _names;                   // names by id; a deque never moves its elements
+    std::unordered_map<std::string_view, int> _ids;   // views into _names, mapped to their ids
+
+    DISALLOW_COPYING_OF(NameTable);
+};
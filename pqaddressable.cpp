@@ -0,0 +1,231 @@
+/*
+ * File Synopsis:
+ * The addressable priority queue heap hands out a handle for every element it holds so that the element's
+ * priority can be changed, or the element removed, in time O(log n). It is a class template, so its
+ * implementation lives in pqaddressable.h. This file instantiates the DataPoint queue (AddressablePQHeap)
+ * and contains its tests, along with a shortest-path time trial that compares changing priorities through
+ * handles against the lazy-deletion workaround on a plain PQHeap.
+ */
+
+#include "pqaddressable.h"
+#include "pqheap.h"
+#include <cmath>
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include "datapoint.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/* The DataPoint queue is instantiated here so that every member function is compiled
+ * even if no test happens to call it.
+ */
+template class BasicAddressablePQHeap<DataPoint, std::less<>, DataPointPriority>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("AddressablePQHeap: example from writeup, validate each step") {
+    AddressablePQHeap pq;
+    Vector<DataPoint> input = {
+        { "R", 4 }, { "A", 5 }, { "B", 3 }, { "K", 7 }, { "G", 2 },
+        { "V", 9 }, { "T", 1 }, { "O", 8 }, { "S", 6 } };
+
+    pq.validateInternalState();
+    for (DataPoint dp : input) {
+        pq.enqueue(dp);
+        pq.validateInternalState();
+    }
+    for (int expected = 1; expected <= 9; expected++) {
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+        pq.validateInternalState();
+    }
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peek());
+}
+
+STUDENT_TEST("AddressablePQHeap: rescheduling deadlines and cancelling jobs through handles") {
+    AddressablePQHeap pq;
+    auto build = pq.enqueue({ "build", 30 });
+    auto test = pq.enqueue({ "test", 40 });
+    auto deploy = pq.enqueue({ "deploy", 50 });
+    auto lint = pq.emplace("lint", 10.0);
+
+    pq.changePriority(deploy, 5);   // moves to the front
+    pq.validateInternalState();
+    EXPECT_EQUAL(pq.peekHandle(), deploy);
+    EXPECT_EQUAL(pq.get(deploy).priority, 5);
+
+    pq.changePriority(lint, 45);    // moves towards the back
+    pq.validateInternalState();
+    DataPoint cancelled = pq.remove(build);
+    DataPoint expected = { "build", 30 };
+    EXPECT_EQUAL(cancelled, expected);
+    EXPECT(!pq.contains(build));
+    EXPECT_ERROR(pq.remove(build));
+    EXPECT_ERROR(pq.changePriority(build, 1));
+    EXPECT_ERROR(pq.get(-1));
+    pq.validateInternalState();
+
+    EXPECT_EQUAL(pq.dequeue().name, "deploy");
+    EXPECT_EQUAL(pq.dequeue().name, "test");
+    EXPECT(pq.contains(lint));
+    EXPECT(!pq.contains(test));
+    EXPECT_EQUAL(pq.dequeue().name, "lint");
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("BasicAddressablePQHeap: random changes and removals match a brute-force model") {
+    BasicAddressablePQHeap<int, less<>, IdentityKey, 4> pq;
+    Vector<int> handles;     // handles of queued elements
+    setRandomSeed(313);
+    for (int step = 0; step < 3000; step++) {
+        int choice = randomInteger(0, 9);
+        if (handles.isEmpty() || choice < 4) {
+            handles.add(pq.enqueue(randomInteger(-1000, 1000)));
+        } else if (choice < 7) {
+            pq.changePriority(handles[randomInteger(0, handles.size() - 1)], randomInteger(-1000, 1000));
+        } else if (choice < 9) {
+            int i = randomInteger(0, handles.size() - 1);
+            pq.remove(handles[i]);
+            handles.remove(i);
+        } else {
+            int smallest = pq.get(handles[0]);
+            for (int handle : handles) {
+                smallest = min(smallest, pq.get(handle));
+            }
+            int front = pq.peekHandle(); // with ties, any of the smallest may be frontmost
+            EXPECT_EQUAL(pq.dequeue(), smallest);
+            for (int i = 0; i < handles.size(); i++) {
+                if (handles[i] == front) {
+                    handles.remove(i);
+                    break;
+                }
+            }
+        }
+        EXPECT_EQUAL(pq.size(), handles.size());
+        pq.validateInternalState();
+    }
+    pq.clear();
+    pq.validateInternalState();
+    EXPECT(pq.isEmpty());
+}
+
+/* A vertex waiting in a shortest-path search, with its tentative distance as its priority. */
+struct Visit {
+    int vertex;
+    double distance;
+};
+
+struct VisitDistance {
+    double operator()(const Visit& visit) const {
+        return visit.distance;
+    }
+    void set(Visit& visit, double distance) const {
+        visit.distance = distance;
+    }
+};
+
+struct Edge {
+    int to;
+    double weight;
+};
+
+/* Helper function that builds a random directed graph on n vertices, each with a path edge to the
+ * next vertex (so everything is reachable from vertex 0) plus degree random edges. */
+Vector<Vector<Edge>> randomGraph(int n, int degree) {
+    Vector<Vector<Edge>> graph(n);
+    for (int v = 0; v < n; v++) {
+        if (v + 1 < n) {
+            graph[v].add({ v + 1, randomReal(50, 100) });
+        }
+        for (int i = 0; i < degree; i++) {
+            graph[v].add({ randomInteger(0, n - 1), randomReal(1, 100) });
+        }
+    }
+    return graph;
+}
+
+static const int NOT_SEEN = -1; // handleOf value of a vertex that has not been enqueued yet
+static const int DONE = -2;     // handleOf value of a vertex whose distance is final
+
+/* Dijkstra's algorithm that keeps one queue entry per vertex and lowers its priority through its handle.
+ * A handle is forgotten as soon as its vertex is dequeued, since the queue may hand it out again. */
+Vector<double> shortestPathsWithHandles(const Vector<Vector<Edge>>& graph, int source) {
+    int n = graph.size();
+    Vector<double> distance(n, INFINITY);
+    Vector<int> handleOf(n, NOT_SEEN);
+    BasicAddressablePQHeap<Visit, less<>, VisitDistance> pq(n);
+    distance[source] = 0;
+    handleOf[source] = pq.enqueue({ source, 0 });
+    while (!pq.isEmpty()) {
+        Visit visit = pq.dequeue();
+        handleOf[visit.vertex] = DONE;
+        for (const Edge& edge : graph[visit.vertex]) {
+            double through = visit.distance + edge.weight;
+            if (handleOf[edge.to] != DONE && through < distance[edge.to]) {
+                distance[edge.to] = through;
+                if (handleOf[edge.to] == NOT_SEEN) {
+                    handleOf[edge.to] = pq.enqueue({ edge.to, through });
+                } else {
+                    pq.changePriority(handleOf[edge.to], through);
+                }
+            }
+        }
+    }
+    return distance;
+}
+
+/* Dijkstra's algorithm with lazy deletion: every improvement enqueues a new entry and entries that are
+ * out of date when they reach the front are skipped. */
+Vector<double> shortestPathsLazy(const Vector<Vector<Edge>>& graph, int source) {
+    int n = graph.size();
+    Vector<double> distance(n, INFINITY);
+    BasicPQHeap<Visit, less<>, VisitDistance> pq(n);
+    distance[source] = 0;
+    pq.enqueue({ source, 0 });
+    while (!pq.isEmpty()) {
+        Visit visit = pq.dequeue();
+        if (visit.distance > distance[visit.vertex]) {
+            continue; // stale entry, the vertex was reached more cheaply since
+        }
+        for (const Edge& edge : graph[visit.vertex]) {
+            double through = visit.distance + edge.weight;
+            if (through < distance[edge.to]) {
+                distance[edge.to] = through;
+                pq.enqueue({ edge.to, through });
+            }
+        }
+    }
+    return distance;
+}
+
+STUDENT_TEST("Shortest paths: handles and lazy deletion find the same distances") {
+    setRandomSeed(2718);
+    for (int n = 1; n <= 2000; n *= 7) {
+        Vector<Vector<Edge>> graph = randomGraph(n, 4);
+        Vector<double> withHandles = shortestPathsWithHandles(graph, 0);
+        Vector<double> lazy = shortestPathsLazy(graph, 0);
+        EXPECT_EQUAL(withHandles, lazy);
+    }
+}
+
+/* Helper functions for the time trial, which only need the work done. */
+void runShortestPathsWithHandles(const Vector<Vector<Edge>>& graph) {
+    shortestPathsWithHandles(graph, 0);
+}
+
+void runShortestPathsLazy(const Vector<Vector<Edge>>& graph) {
+    shortestPathsLazy(graph, 0);
+}
+
+STUDENT_TEST("Shortest paths time trial, changePriority through handles versus lazy deletion") {
+    for (int n = 100000; n <= 1000000; n *= 3) {
+        for (int degree = 4; degree <= 16; degree *= 4) {
+            Vector<Vector<Edge>> graph = randomGraph(n, degree);
+            cout << "    n=" << n << ", " << degree + 1 << " edges per vertex" << endl;
+            TIME_OPERATION(n, runShortestPathsWithHandles(graph));
+            TIME_OPERATION(n, runShortestPathsLazy(graph));
+        }
+    }
+}
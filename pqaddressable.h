@@ -0,0 +1,494 @@
+#pragma once
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "strlib.h"
+#include "pqheap.h"
+
+/**
+ * Priority queue of elements of type T in which every queued element can be
+ * found again through a handle, so that its priority can be changed or the
+ * element removed in time O(log n) without draining the queue.
+ *
+ * enqueue returns a handle, a small integer that names the element until it
+ * leaves the queue (by dequeue or remove). After that the handle may be
+ * handed out again for a new element, so a caller that keeps handles should
+ * forget one once its element is gone; contains tells whether a handle
+ * currently names a queued element.
+ *
+ * The heap is an array of (priority, handle) entries sifted by the siftUp and
+ * siftDown of pqheap.h, which report every entry they place so that the
+ * position of each handle in the heap is kept up to date. Elements sit in a
+ * payload array indexed by handle and never move while queued.
+ *
+ * The template parameters mean the same as for BasicPQHeap. changePriority
+ * writes the new priority into the element with KeyFn's set member, which
+ * IdentityKey and DataPointPriority provide.
+ */
+template <typename T, typename Compare = std::less<>, typename KeyFn = IdentityKey, int Arity = 2>
+class BasicAddressablePQHeap {
+    static_assert(Arity >= 2, "A heap node needs at least two children");
+
+public:
+    /* The type of priority that KeyFn reads from an element. */
+    using Key = std::decay_t<decltype(std::declval<KeyFn>()(std::declval<const T&>()))>;
+
+    /* Names a queued element; returned by enqueue. */
+    using Handle = int;
+
+    /**
+     * Creates a new, empty priority queue.
+     */
+    BasicAddressablePQHeap();
+
+    /**
+     * Creates a new, empty priority queue with room for capacity elements
+     * allocated up front.
+     *
+     * @param capacity The number of slots to allocate.
+     */
+    BasicAddressablePQHeap(int capacity);
+
+    /**
+     * Cleans up all memory allocated by this priority queue.
+     */
+    ~BasicAddressablePQHeap();
+
+    /**
+     * Adds a new element into the queue and returns the handle that names it.
+     * This operation runs in time O(log n).
+     *
+     * @param element The element to add.
+     * @return The handle of the new element.
+     */
+    Handle enqueue(const T& element);
+    Handle enqueue(T&& element);
+
+    /**
+     * Adds a new element into the queue, constructing it from the given
+     * arguments, and returns its handle. This operation runs in time O(log n).
+     *
+     * @param args The arguments used to brace-initialize the element.
+     * @return The handle of the new element.
+     */
+    template <typename... Args>
+    Handle emplace(Args&&... args);
+
+    /**
+     * Removes and returns the element that is frontmost in this priority queue.
+     * Its handle is no longer valid afterwards.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(log n).
+     *
+     * @return The frontmost element, which is removed from queue.
+     */
+    T dequeue();
+
+    /**
+     * Removes and returns the element named by the given handle, wherever it
+     * is in the queue. If the handle does not name a queued element, this
+     * function calls error().
+     *
+     * This operation runs in time O(log n).
+     *
+     * @param handle The handle of the element to remove.
+     * @return The removed element.
+     */
+    T remove(Handle handle);
+
+    /**
+     * Changes the priority of the element named by the given handle, moving it
+     * towards the front or the back of the queue as needed. The new priority
+     * is also written into the element. If the handle does not name a queued
+     * element, this function calls error().
+     *
+     * This operation runs in time O(log n).
+     *
+     * @param handle The handle of the element to change.
+     * @param priority The new priority of the element.
+     */
+    void changePriority(Handle handle, const Key& priority);
+
+    /**
+     * Returns the element named by the given handle without removing it. If
+     * the handle does not name a queued element, this function calls error().
+     *
+     * This operation runs in time O(1).
+     *
+     * @param handle The handle of the element.
+     * @return The element.
+     */
+    const T& get(Handle handle) const;
+
+    /**
+     * Returns whether the given handle names an element that is in the queue.
+     *
+     * This operation runs in time O(1).
+     */
+    bool contains(Handle handle) const;
+
+    /**
+     * Returns, but does not remove, the element that is frontmost.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(1).
+     *
+     * @return frontmost element
+     */
+    T peek() const;
+
+    /**
+     * Returns the handle of the frontmost element.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(1).
+     *
+     * @return handle of the frontmost element
+     */
+    Handle peekHandle() const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Removes all elements from the priority queue. Every handle becomes
+     * invalid.
+     *
+     * This operation runs in time O(capacity) since every handle is marked
+     * free again.
+     */
+    void clear();
+
+    /*
+     * This function exists purely for testing purposes. It prints the heap of
+     * priorities along with the handle and element each one refers to.
+     */
+    void printDebugInfo(std::string msg) const;
+
+    /*
+     * This function exits purely for testing purposes. It verifies the heap
+     * order, that every entry's priority matches its element, and that the
+     * position index and the free handles agree with the heap.
+     * If a problem is detected, this function calls error().
+     */
+    void validateInternalState() const;
+
+private:
+    static constexpr int INITIAL_CAPACITY = 10;
+    static constexpr int NONE = -1; // position of a handle that is not in the queue
+    static constexpr int PADDING = Arity - 1; // unused slots in front of index 0 that align each group of children
+
+    /* One node of the heap: an element's priority and the handle of the element. */
+    struct Entry {
+        Key key;
+        Handle handle;
+    };
+
+    Entry* _heap;           // heap of priorities and handles
+    T* _payloads;           // elements, indexed by handle
+    int* _positions;        // _positions[h] is the index in _heap of handle h, or NONE
+    int* _freeHandles;      // stack of unused handles, _numAllocated - _numFilled of them
+    int _numAllocated;      // number of slots allocated in each array
+    int _numFilled;         // number of elements in the queue
+
+    Compare _compare;       // orders two priorities, true if the first is more urgent
+    KeyFn _key;             // reads and writes the priority of an element
+
+    void allocateArrays(int capacity);
+    void freeArrays();
+    void enlargeSize();
+    void checkHandle(Handle handle) const;
+    void restoreOrder(int index);  // sifts the entry at index up or down, whichever it needs
+
+    /* Returns the entry comparison handed to siftUp and siftDown. */
+    auto entryOrder() const {
+        return [this](const Entry& a, const Entry& b) {
+            return _compare(a.key, b.key);
+        };
+    }
+
+    /* Returns the hook that records where siftUp and siftDown place each entry. */
+    auto recordPosition() {
+        return [this](int index) {
+            _positions[_heap[index].handle] = index;
+        };
+    }
+
+    DISALLOW_COPYING_OF(BasicAddressablePQHeap);
+};
+
+/*
+ * The allocators size every array for the given number of elements and mark
+ * every handle as free.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::BasicAddressablePQHeap() {
+    allocateArrays(INITIAL_CAPACITY);
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::BasicAddressablePQHeap(int capacity) {
+    allocateArrays(std::max(capacity, 1));
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::~BasicAddressablePQHeap() {
+    freeArrays();
+}
+
+/*
+ * Private helper that allocates all four arrays with room for capacity
+ * elements. The free stack is filled so that handle 0 is handed out first.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::allocateArrays(int capacity) {
+    _numAllocated = capacity;
+    _numFilled = 0;
+    _heap = allocateAlignedArray<Entry>(capacity, PADDING);
+    _payloads = new T[capacity]();
+    _positions = new int[capacity];
+    _freeHandles = new int[capacity];
+    for (int i = 0; i < capacity; i++) {
+        _positions[i] = NONE;
+        _freeHandles[i] = capacity - 1 - i;
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::freeArrays() {
+    freeAlignedArray(_heap, _numAllocated, PADDING);
+    delete[] _payloads;
+    delete[] _positions;
+    delete[] _freeHandles;
+}
+
+/*
+ * Private helper that doubles every array. It is only called when the queue
+ * is full, so every old handle is in use and keeps its number; the new free
+ * stack holds exactly the handles past the old capacity.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::enlargeSize() {
+    int newAllocated = _numAllocated * 2;
+    Entry* newHeap = allocateAlignedArray<Entry>(newAllocated, PADDING);
+    T* newPayloads = new T[newAllocated]();
+    int* newPositions = new int[newAllocated];
+    int* newFreeHandles = new int[newAllocated];
+    for (int i = 0; i < _numAllocated; i++) {
+        newHeap[i] = _heap[i];
+        newPayloads[i] = std::move(_payloads[i]);
+        newPositions[i] = _positions[i];
+    }
+    for (int i = _numAllocated; i < newAllocated; i++) {
+        newPositions[i] = NONE;
+    }
+    for (int i = 0; i < newAllocated - _numAllocated; i++) {
+        newFreeHandles[i] = newAllocated - 1 - i;
+    }
+    freeArrays();
+    _heap = newHeap;
+    _payloads = newPayloads;
+    _positions = newPositions;
+    _freeHandles = newFreeHandles;
+    _numAllocated = newAllocated;
+}
+
+/*
+ * Private helper that calls error() unless handle names a queued element.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::checkHandle(Handle handle) const {
+    if (!contains(handle)) {
+        error("Handle " + integerToString(handle) + " does not name an element in the queue");
+    }
+}
+
+/*
+ * Private helper for an entry whose priority changed or that was moved into a
+ * hole: it belongs either further up or further down, never both.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::restoreOrder(int index) {
+    if (index > 0 && _compare(_heap[index].key, _heap[(index - 1) / Arity].key)) {
+        siftUp<Arity>(_heap, index, entryOrder(), recordPosition());
+    } else {
+        siftDown<Arity>(_heap, index, _numFilled, entryOrder(), recordPosition());
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+typename BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::Handle
+BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::enqueue(const T& element) {
+    return enqueue(T(element));
+}
+
+/*
+ * The element is moved into the payload slot of a free handle, which it keeps
+ * until it leaves the queue; its entry is added at the end of the heap and
+ * sifted up, which records its position.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+typename BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::Handle
+BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::enqueue(T&& element) {
+    if (_numFilled == _numAllocated) {
+        enlargeSize();
+    }
+    Handle handle = _freeHandles[_numAllocated - _numFilled - 1];
+    _payloads[handle] = std::move(element);
+    _heap[_numFilled] = { _key(_payloads[handle]), handle };
+    _numFilled++;
+    siftUp<Arity>(_heap, _numFilled - 1, entryOrder(), recordPosition());
+    return handle;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+template <typename... Args>
+typename BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::Handle
+BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::emplace(Args&&... args) {
+    return enqueue(buildElement<T>(std::forward<Args>(args)...));
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+T BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::dequeue() {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    return remove(_heap[0].handle);
+}
+
+/*
+ * The element is moved out of its payload slot and its handle pushed back on
+ * the free stack. The last entry of the heap fills the hole the element's
+ * entry leaves and is sifted whichever way it needs to go.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+T BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::remove(Handle handle) {
+    checkHandle(handle);
+    int index = _positions[handle];
+    T removed = std::move(_payloads[handle]);
+    _positions[handle] = NONE;
+    _numFilled--;
+    _freeHandles[_numAllocated - _numFilled - 1] = handle;
+    if (index < _numFilled) {
+        _heap[index] = _heap[_numFilled];
+        _positions[_heap[index].handle] = index;
+        restoreOrder(index);
+    }
+    return removed;
+}
+
+/*
+ * The new priority is written into the element and read back through KeyFn,
+ * so the entry always holds exactly the priority the element reports.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::changePriority(Handle handle, const Key& priority) {
+    checkHandle(handle);
+    _key.set(_payloads[handle], priority);
+    int index = _positions[handle];
+    _heap[index].key = _key(_payloads[handle]);
+    restoreOrder(index);
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+const T& BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::get(Handle handle) const {
+    checkHandle(handle);
+    return _payloads[handle];
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+bool BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::contains(Handle handle) const {
+    return handle >= 0 && handle < _numAllocated && _positions[handle] != NONE;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+T BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::peek() const {
+    return _payloads[peekHandle()];
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+typename BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::Handle
+BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::peekHandle() const {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    return _heap[0].handle;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+bool BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::isEmpty() const {
+    return _numFilled == 0;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+int BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::size() const {
+    return _numFilled;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::clear() {
+    _numFilled = 0;
+    for (int i = 0; i < _numAllocated; i++) {
+        _positions[i] = NONE;
+        _freeHandles[i] = _numAllocated - 1 - i;
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::printDebugInfo(std::string msg) const {
+    std::cout << msg << std::endl;
+    for (int i = 0; i < size(); i++) {
+        std::cout << "[" << i << "] = " << _heap[i].key << " -> handle " << _heap[i].handle
+                  << " = " << _payloads[_heap[i].handle] << std::endl;
+    }
+}
+
+/*
+ * Checks the heap order, that each entry's priority matches its element, that
+ * the position index points back at each entry, and that every handle is
+ * either queued or free but not both.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicAddressablePQHeap<T, Compare, KeyFn, Arity>::validateInternalState() const {
+    if (_numFilled > _numAllocated) error("Too many elements in not enough space!");
+
+    for (int i = 0; i < _numFilled; i++) {
+        Handle handle = _heap[i].handle;
+        if (handle < 0 || handle >= _numAllocated || _positions[handle] != i) {
+            error("The position index does not point back at heap index " + integerToString(i) + ".");
+        }
+        Key stored = _key(_payloads[handle]);
+        if (_compare(stored, _heap[i].key) || _compare(_heap[i].key, stored)) {
+            error("The priority at index " + integerToString(i) + " does not match its element.");
+        }
+        if (i > 0 && _compare(_heap[i].key, _heap[(i - 1) / Arity].key)) {
+            error("The priority of index " + integerToString(i) + " has an incorrect priority relationship to its parent.");
+        }
+    }
+    for (int i = 0; i < _numAllocated - _numFilled; i++) {
+        if (_positions[_freeHandles[i]] != NONE) {
+            error("Handle " + integerToString(_freeHandles[i]) + " is both free and in the queue.");
+        }
+    }
+}
+
+/**
+ * Priority queue of DataPoints with handles, binary heap.
+ */
+using AddressablePQHeap = BasicAddressablePQHeap<DataPoint, std::less<>, DataPointPriority>;
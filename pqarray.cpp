@@ -7,6 +7,8 @@
  */
 
 #include "pqarray.h"
+#include <algorithm>
+#include "pqblockarray.h"
 #include "error.h"
 #include "random.h"
 #include "strlib.h"
@@ -14,8 +16,17 @@
 #include "testing/SimpleTest.h"
 using namespace std;
 
-// program constant
+// program constants
 static const int INITIAL_CAPACITY = 10;
+static const int MIN_MERGED_BATCH = 4;  // smaller batches are enqueued one element at a time
+
+/*
+ * The order the array is kept in: larger priority values first, so that the most urgent element is
+ * in the last-filled index.
+ */
+static bool largerPriorityFirst(const DataPoint& a, const DataPoint& b) {
+    return a.priority > b.priority;
+}
 
 /*
  * The constructor initializes all of the member variables needed for
@@ -25,8 +36,44 @@ static const int INITIAL_CAPACITY = 10;
  */
 PQArray::PQArray() {
     _numAllocated = INITIAL_CAPACITY;
-    _elements = new DataPoint[_numAllocated](); // allocated zero'd memory
+    _resource = std::pmr::get_default_resource();
+    _elements = allocateElements(_numAllocated); // allocated zero'd memory
+    _numFilled = 0;
+    _minCapacity = INITIAL_CAPACITY;
+    _growthFactor = 2.0;
+    _shrinkOnDequeue = true;
+    _numCopies = 0;
+}
+
+/*
+ * This constructor starts with an array of exactly the vector's size
+ * (but at least one slot) and lets buildFrom fill and sort it.
+ */
+PQArray::PQArray(const Vector<DataPoint>& elements) {
+    _numAllocated = max(elements.size(), 1);
+    _resource = std::pmr::get_default_resource();
+    _elements = allocateElements(_numAllocated);
+    _numFilled = 0;
+    _minCapacity = INITIAL_CAPACITY;
+    _growthFactor = 2.0;
+    _shrinkOnDequeue = true;
+    _numCopies = 0;
+    buildFrom(elements);
+}
+
+/*
+ * This constructor is the same as the default one except that the array
+ * is taken from the arena given as the parameter.
+ */
+PQArray::PQArray(std::pmr::memory_resource* arena) {
+    _numAllocated = INITIAL_CAPACITY;
+    _resource = arena;
+    _elements = allocateElements(_numAllocated);
     _numFilled = 0;
+    _minCapacity = INITIAL_CAPACITY;
+    _growthFactor = 2.0;
+    _shrinkOnDequeue = true;
+    _numCopies = 0;
 }
 
 /* The destructor is responsible for cleaning up any resources
@@ -34,44 +81,185 @@ PQArray::PQArray() {
  * memory that was allocated for the PQArray is deleted here.
  */
 PQArray::~PQArray() {
-    delete[] _elements;
+    freeElements(_elements, _numAllocated);
+}
+
+/* Function synopsis:
+ * These helpers stand in for new[] and delete[]. They take the array from, and give it back to,
+ * the memory resource the queue was built with, which is the general heap unless an arena was given.
+ */
+DataPoint* PQArray::allocateElements(int count) const {
+    std::pmr::polymorphic_allocator<DataPoint> allocator(_resource);
+    DataPoint* elements = allocator.allocate(count);
+    for (int i = 0; i < count; i++) {
+        allocator.construct(elements + i);
+    }
+    return elements;
+}
+
+void PQArray::freeElements(DataPoint* elements, int count) const {
+    std::pmr::polymorphic_allocator<DataPoint> allocator(_resource);
+    for (int i = 0; i < count; i++) {
+        elements[i].~DataPoint();
+    }
+    allocator.deallocate(elements, count);
+}
+
+/*
+ * Function Synopsis:
+ * The enqueue function takes in one parameter which is a Datapoint to be added to the array. A copy
+ * is made and handed to the moving version of enqueue.
+ * This function has a void return type, so no value is returned.
+ */
+void PQArray::enqueue(const DataPoint& elem) {
+    _numCopies++;
+    enqueue(DataPoint(elem));
 }
 
 /*
  * Function Synopsis:
- * The enqueue function takes in one parameter which is a Datapoint to be added to the array.
+ * This version of enqueue finds the slot for its parameter with a binary search and then shifts every
+ * element after that slot one place towards the end in a single pass. The new element goes after any
+ * elements of equal priority, so it leaves the queue before them. Nothing is copied: the shifted
+ * elements and the new one are all moved.
  * This function has a void return type, so no value is returned.
  */
-void PQArray::enqueue(DataPoint elem) {
+void PQArray::enqueue(DataPoint&& elem) {
     if(_numFilled+1 > _numAllocated){
         enlargeSize();
     }
 
-    _elements[_numFilled] = elem;
-    for(int i = _numFilled-1; i>=0; i--){
-        if(_elements[i].priority < elem.priority){
-            swap(i,i+1);
-        }
-        else{
-            break;
+    DataPoint* end = _elements + _numFilled;
+    DataPoint* slot = upper_bound(_elements, end, elem, largerPriorityFirst);//first element less urgent than elem
+    move_backward(slot, end, end + 1);
+    *slot = std::move(elem);
+    _numFilled++;
+}
+
+/*
+ * Function Synopsis:
+ * The emplace function builds a DataPoint out of its two parameters, a name and a priority, and
+ * moves it into the array. No value is returned.
+ */
+void PQArray::emplace(string name, double priority) {
+    enqueue(DataPoint{ std::move(name), priority });
+}
+
+/*
+ * Function Synopsis:
+ * buildFrom replaces the contents of the array with the elements of its parameter vector. If the
+ * array is too small it is replaced once by one of exactly the right size. The elements are then
+ * sorted in one pass into decreasing order of priority value, the same order enqueue keeps, so
+ * the most urgent element ends up in the last-filled index. No value is returned.
+ */
+void PQArray::buildFrom(const Vector<DataPoint>& elements) {
+    _numFilled = 0;
+    if (elements.size() > _numAllocated) {
+        resize(elements.size());
+    }
+    for (int i = 0; i < elements.size(); i++) {
+        _elements[i] = elements[i];
+    }
+    _numFilled = elements.size();
+    sort(_elements, _elements + _numFilled, largerPriorityFirst);
+}
+
+/*
+ * Function Synopsis:
+ * enqueueAll appends the elements of its parameter vector after the filled slots, growing the array
+ * once if they do not fit. Inserting them one at a time would shift part of the array once per element,
+ * so instead the batch is sorted into the same decreasing order by itself and the two sorted runs are
+ * merged, which moves each element a single time. A batch of fewer than MIN_MERGED_BATCH elements shifts
+ * less than the merge moves, so it is enqueued an element at a time. No value is returned.
+ */
+void PQArray::enqueueAll(const Vector<DataPoint>& elements) {
+    int count = elements.size();
+    if (count < MIN_MERGED_BATCH) {
+        for (const DataPoint& elem : elements) {
+            enqueue(elem);
         }
+        return;
     }
-    _numFilled++;
+    if (_numFilled + count > _numAllocated) {
+        resize(max(_numFilled + count, grownCapacity(_numAllocated, _growthFactor)));
+    }
+    for (int i = 0; i < count; i++) {
+        _elements[_numFilled + i] = elements[i];
+    }
+    sort(_elements + _numFilled, _elements + _numFilled + count, largerPriorityFirst);
+    inplace_merge(_elements, _elements + _numFilled, _elements + _numFilled + count, largerPriorityFirst);
+    _numFilled += count;
 }
 
 /* Function synopsis:
- * Added by student, this helper function is called to double the size of allocated spaces in the array.
- * It is a void function so nothing is returned and there are no parameters.
+ * Added by student, this helper is called to grow the array by the growth factor (doubling it by
+ * default). It is a void function so nothing is returned and there are no parameters.
  */
 void PQArray::enlargeSize(){
-    DataPoint* newPQ = new DataPoint[_numAllocated*2];//creates new array with twice the memory of the current array
+    resize(grownCapacity(_numAllocated, _growthFactor));
+}
+
+/* Function synopsis:
+ * This helper replaces the array by a new one with newCapacity slots, which must be at least the
+ * number of elements, and moves the elements over. Every call is recorded in the resize counts.
+ * It is used for growing, shrinking and reserving. Nothing is returned.
+ */
+void PQArray::resize(int newCapacity){
+    DataPoint* newPQ = allocateElements(newCapacity);//creates new array with room for newCapacity elements
     for(int i = 0; i<size(); i++){
-        newPQ[i] = _elements[i];//transfers all data values from the original array to the new one
+        newPQ[i] = std::move(_elements[i]);//transfers all data values from the original array to the new one
     }
-    delete[] _elements;
+    freeElements(_elements, _numAllocated);
     _elements = newPQ;
-    _numAllocated *= 2;
+    _numAllocated = newCapacity;
+    _stats.reallocations++;
+    _stats.bytesCopied += long(size()) * long(sizeof(DataPoint));
+}
+
+/*
+ * reserve grows the array once to hold at least capacity elements and
+ * remembers that number as the floor for automatic shrinking.
+ */
+void PQArray::reserve(int capacity) {
+    if (capacity > _numAllocated) {
+        resize(capacity);
+    }
+    _minCapacity = max(capacity, 1);
+}
+
+/*
+ * shrinkToFit replaces the array by one that holds exactly the current
+ * elements (at least one slot) and resets the floor for automatic shrinking.
+ */
+void PQArray::shrinkToFit() {
+    _minCapacity = min(_minCapacity, INITIAL_CAPACITY);
+    int fitted = max(_numFilled, 1);
+    if (fitted < _numAllocated) {
+        resize(fitted);
+    }
+}
+
+/*
+ * A growth factor of one or less could never make room for another
+ * element, so it is reported as an error.
+ */
+void PQArray::setGrowthFactor(double factor) {
+    if (!(factor > 1)) {
+        error("Growth factor must be greater than 1");
+    }
+    _growthFactor = factor;
+}
+
+void PQArray::setShrinkOnDequeue(bool enabled) {
+    _shrinkOnDequeue = enabled;
+}
+
+ResizeStats PQArray::getResizeStats() const {
+    return _stats;
+}
 
+long PQArray::getCopyCount() const {
+    return _numCopies;
 }
 
 /*
@@ -100,13 +288,45 @@ DataPoint PQArray::peek() const {
  * This function returns the value of the frontmost element and removes
  * it from the queue.  Because the frontmost element was at the
  * last-filled index, decrementing filled count is sufficient to remove it.
+ * That slot no longer belongs to the queue, so the element is moved out
+ * of it rather than copied. If the queue has drained well below its
+ * capacity, the array is then shrunk (see shrunkCapacity in pqresize.h).
  */
 DataPoint PQArray::dequeue() {
-    DataPoint front = peek();
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
     _numFilled--;
+    DataPoint front = std::move(_elements[_numFilled]);
+    if (_shrinkOnDequeue) {
+        int shrunk = shrunkCapacity(_numFilled, _numAllocated, _minCapacity, _growthFactor);
+        if (shrunk < _numAllocated) {
+            resize(shrunk);
+        }
+    }
     return front;
 }
 
+/*
+ * The frontmost elements sit at the end of the array, so dequeueMany moves
+ * them out from the last-filled index backwards, most urgent first, and
+ * then checks once whether the array should shrink.
+ */
+int PQArray::dequeueMany(int k, DataPoint* out) {
+    int count = max(0, min(k, _numFilled));
+    for (int i = 0; i < count; i++) {
+        _numFilled--;
+        out[i] = std::move(_elements[_numFilled]);
+    }
+    if (_shrinkOnDequeue) {
+        int shrunk = shrunkCapacity(_numFilled, _numAllocated, _minCapacity, _growthFactor);
+        if (shrunk < _numAllocated) {
+            resize(shrunk);
+        }
+    }
+    return count;
+}
+
 /*
  * Returns true if no elements in the queue, false otherwise
  */
@@ -126,16 +346,6 @@ void PQArray::clear() {
     _numFilled = 0;
 }
 
-/*
- * Private member function. This helper exchanges the element at
- * indexA with the element at indexB.
- */
-void PQArray::swap(int indexA, int indexB) {
-    DataPoint tmp = _elements[indexA];
-    _elements[indexA] = _elements[indexB];
-    _elements[indexB] = tmp;
-}
-
 /*
  * Prints the contents of internal array for debugging purposes.
  */
@@ -172,14 +382,16 @@ void PQArray::validateInternalState() const {
 
 /* * * * * * Test Cases Below This Point * * * * * */
 
-void fillQueue(PQArray& pq, int n) {
+template <typename PQ>
+void fillQueue(PQ& pq, int n) {
     pq.clear(); // start with empty queue
     for (int i = 0; i < n; i++) {
         pq.enqueue({ "", randomReal(0, 10) });
     }
 }
 
-void emptyQueue(PQArray& pq, int n) {
+template <typename PQ>
+void emptyQueue(PQ& pq, int n) {
     for (int i = 0; i < n; i++) {
         pq.dequeue();
     }
@@ -269,6 +481,166 @@ STUDENT_TEST("Timing data 5/5 for enqueue"){
     TIME_OPERATION(n, emptyQueue(pq, n));
 }
 
+/* The same fill and drain as the timing data above, ten times larger. Filling the flat array is still
+ * quadratic, so its largest sizes take minutes rather than seconds. */
+STUDENT_TEST("PQArray time trial, binary insertion versus BlockPQArray at 10x n"){
+    for (int n = 50000; n <= 800000; n *= 2) {
+        PQArray array;
+        BlockPQArray blocks;
+        TIME_OPERATION(n, fillQueue(array, n));
+        TIME_OPERATION(n, emptyQueue(array, n));
+        TIME_OPERATION(n, fillQueue(blocks, n));
+        TIME_OPERATION(n, emptyQueue(blocks, n));
+    }
+}
+
+
+STUDENT_TEST("PQArray built from a vector matches enqueuing one at a time") {
+    Vector<DataPoint> input = {
+        { "R", 4 }, { "A", 5 }, { "B", 3 }, { "K", 7 }, { "G", 2 },
+        { "V", 9 }, { "T", 1 }, { "O", 8 }, { "S", 6 } };
+    PQArray built(input);
+    built.validateInternalState();
+    EXPECT_EQUAL(built.size(), input.size());
+
+    PQArray pq;
+    pq.enqueue({ "X", 0 });
+    pq.buildFrom(input);
+    pq.validateInternalState();
+    for (int expected = 1; expected <= 9; expected++) {
+        EXPECT_EQUAL(built.dequeue().priority, expected);
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+    }
+    EXPECT(built.isEmpty());
+    EXPECT(pq.isEmpty());
+
+    PQArray empty(Vector<DataPoint>{});
+    EXPECT(empty.isEmpty());
+    empty.enqueue({ "", 1 });
+    EXPECT_EQUAL(empty.size(), 1);
+}
+
+STUDENT_TEST("PQArray: enqueueAll merges batches, dequeueMany drains into a buffer") {
+    setRandomSeed(20);
+    PQArray pq;
+    Vector<double> all;
+    for (int batchSize : { 1, 0, 30, 2, 300 }) {
+        Vector<DataPoint> batch;
+        for (int i = 0; i < batchSize; i++) {
+            batch.add({ "", double(randomInteger(-50, 50)) });
+            all.add(batch[i].priority);
+        }
+        pq.enqueueAll(batch);
+        pq.validateInternalState();
+        EXPECT_EQUAL(pq.size(), all.size());
+    }
+    sort(all.begin(), all.end());
+
+    Vector<DataPoint> out(all.size() + 5);
+    EXPECT_EQUAL(pq.dequeueMany(10, &out[0]), 10);
+    EXPECT_EQUAL(pq.dequeueMany(all.size(), &out[10]), all.size() - 10);
+    for (int i = 0; i < all.size(); i++) {
+        EXPECT_EQUAL(out[i].priority, all[i]);
+    }
+    EXPECT(pq.isEmpty());
+    EXPECT_EQUAL(pq.dequeueMany(3, &out[0]), 0);
+}
+
+/* Helper functions for the batch trial: randomBatch makes n elements of random priority, and addBatches
+ * adds every element of every batch, either with enqueueAll or with one enqueue per element. */
+Vector<DataPoint> randomBatch(int n) {
+    Vector<DataPoint> batch;
+    for (int i = 0; i < n; i++) {
+        batch.add({ "", randomReal(0, 100) });
+    }
+    return batch;
+}
+
+void addBatches(PQArray& pq, const Vector<Vector<DataPoint>>& batches, bool useEnqueueAll) {
+    for (const Vector<DataPoint>& batch : batches) {
+        if (useEnqueueAll) {
+            pq.enqueueAll(batch);
+        } else {
+            for (const DataPoint& dp : batch) {
+                pq.enqueue(dp);
+            }
+        }
+    }
+}
+
+STUDENT_TEST("PQArray time trial, enqueueAll versus enqueue by batch size") {
+    int n = 20000;
+    int added = 4096;
+    Vector<DataPoint> start = randomBatch(n);
+    for (int batchSize = 1; batchSize <= 256; batchSize *= 4) {
+        Vector<Vector<DataPoint>> batches;
+        for (int b = 0; b < added / batchSize; b++) {
+            batches.add(randomBatch(batchSize));
+        }
+        cout << "    queue of " << n << ", " << added << " elements added in batches of " << batchSize << endl;
+        PQArray oneAtATime(start);
+        PQArray merged(start);
+        TIME_OPERATION(added, addBatches(oneAtATime, batches, false));
+        TIME_OPERATION(added, addBatches(merged, batches, true));
+    }
+}
+
+STUDENT_TEST("PQArray: reserve, growth factor, shrink on dequeue and shrinkToFit") {
+    PQArray pq;
+    pq.reserve(1000);
+    for (int i = 0; i < 1000; i++) {
+        pq.enqueue({ "", double(i % 37) });
+    }
+    EXPECT_EQUAL(pq.getResizeStats().reallocations, 1);
+    EXPECT_EQUAL(pq.getResizeStats().bytesCopied, 0);
+
+    // the reserved capacity is a floor, so draining does not shrink below it
+    emptyQueue(pq, 1000);
+    EXPECT_EQUAL(pq.getResizeStats().reallocations, 1);
+
+    PQArray grown;
+    grown.setGrowthFactor(4);
+    for (int i = 0; i < 640; i++) {
+        grown.enqueue({ "", double(i) });
+    }
+    EXPECT_EQUAL(grown.getResizeStats().reallocations, 3); // 10 -> 40 -> 160 -> 640
+    EXPECT_ERROR(grown.setGrowthFactor(1));
+
+    // drained to a sixteenth of its capacity, the array shrinks; going back and forth stays put
+    emptyQueue(grown, 600);
+    grown.validateInternalState();
+    long shrinks = grown.getResizeStats().reallocations - 3;
+    EXPECT(shrinks >= 1);
+    for (int i = 0; i < 100; i++) {
+        grown.enqueue({ "", double(i) });
+        grown.dequeue();
+    }
+    EXPECT_EQUAL(grown.getResizeStats().reallocations, 3 + shrinks);
+
+    grown.shrinkToFit();
+    EXPECT_EQUAL(grown.size(), 40);
+    grown.validateInternalState();
+    for (int i = 600; i < 640; i++) {
+        DataPoint expected = { "", double(i) };
+        EXPECT_EQUAL(grown.dequeue(), expected);
+    }
+}
+
+STUDENT_TEST("PQArray: array taken from an arena, including every resize") {
+    // The arena has no upstream, so any allocation that does not fit in the buffer throws.
+    Vector<char> buffer(1 << 16);
+    std::pmr::monotonic_buffer_resource arena(&buffer[0], buffer.size(), std::pmr::null_memory_resource());
+    PQArray pq(&arena);
+    for (int i = 0; i < 300; i++) {
+        pq.enqueue({ "", double((i * 7) % 300) });
+    }
+    pq.validateInternalState();
+    EXPECT(pq.getResizeStats().reallocations > 0);
+    for (int i = 0; i < 300; i++) {
+        EXPECT_EQUAL(pq.dequeue().priority, i);
+    }
+    EXPECT(pq.isEmpty());
+}
 
 PROVIDED_TEST("PQArray example from writeup") {
     PQArray pq;
@@ -1,6 +1,10 @@
 #pragma once
+#include <memory_resource>
+#include <string>
 #include "testing/MemoryUtils.h"
 #include "datapoint.h"
+#include "vector.h"
+#include "pqresize.h"
 
 /**
  * Priority queue of DataPoints implemented using a sorted array.
@@ -12,18 +16,82 @@ public:
      */
     PQArray();
 
+    /**
+     * Creates a priority queue holding a copy of every element of the given
+     * vector. The array is allocated once at the right size and sorted once,
+     * which runs in time O(n log n) instead of the O(n^2) of enqueuing the
+     * elements one at a time.
+     *
+     * @param elements The elements to start with.
+     */
+    PQArray(const Vector<DataPoint>& elements);
+
+    /**
+     * Creates a new, empty priority queue whose array, and every array that
+     * replaces it, comes from the given arena (e.g. a monotonic or pool
+     * memory resource) instead of the general heap. DataPoint names are
+     * std::strings, so long names are still allocated with malloc; use
+     * ArenaPQHeap to keep names in the arena as well. The arena must outlive
+     * the queue.
+     *
+     * @param arena The memory resource to allocate from.
+     */
+    PQArray(std::pmr::memory_resource* arena);
+
     /**
      * Cleans up all memory allocated by this priority queue.
      */
     ~PQArray();
 
     /**
-     * Adds a new element into the queue. This operation runs in time O(N),
-     * where n is the number of elements in the queue.
+     * Adds a new element into the queue. The slot is found by binary search
+     * and the elements after it are shifted in one pass, so this operation
+     * runs in time O(N), where n is the number of elements in the queue,
+     * but makes only O(log n) comparisons. BlockPQArray in pqblockarray.h
+     * keeps the same order in blocks and moves only O(sqrt n) elements.
      *
      * @param element The element to add.
      */
-    void enqueue(DataPoint element);
+    void enqueue(const DataPoint& element);
+
+    /**
+     * Adds a new element into the queue, moving it in rather than copying it.
+     * This operation runs in time O(N).
+     *
+     * @param element The element to add, which is left in a moved-from state.
+     */
+    void enqueue(DataPoint&& element);
+
+    /**
+     * Adds a new element with the given name and priority into the queue
+     * without the caller having to build a DataPoint first.
+     * This operation runs in time O(N).
+     *
+     * @param name The name of the new element.
+     * @param priority The priority of the new element.
+     */
+    void emplace(std::string name, double priority);
+
+    /**
+     * Replaces the contents of the queue with a copy of every element of the
+     * given vector, resizing the array at most once and sorting it once.
+     * This operation runs in time O(n log n).
+     *
+     * @param elements The elements to put in the queue.
+     */
+    void buildFrom(const Vector<DataPoint>& elements);
+
+    /**
+     * Adds a copy of every element of the given vector to the queue,
+     * resizing the array at most once. The batch is sorted on its own and
+     * merged with the array, which moves every element once, so this
+     * operation runs in time O(n + k log k) where k enqueues would take
+     * O(k n). The crossover trial in pqarray.cpp finds enqueue faster only
+     * for batches of fewer than four elements, which are enqueued instead.
+     *
+     * @param elements The elements to add.
+     */
+    void enqueueAll(const Vector<DataPoint>& elements);
 
     /**
      * Removes and returns the element that is frontmost in this priority queue.
@@ -41,6 +109,20 @@ public:
      */
     DataPoint dequeue();
 
+    /**
+     * Removes the k frontmost elements and moves them, most urgent first,
+     * into out[0] .. out[k-1], which the caller must have room for. If fewer
+     * than k elements are queued, all of them are removed. The array is
+     * shrunk at most once, at the end.
+     *
+     * This operation runs in time O(k).
+     *
+     * @param k The most elements to remove.
+     * @param out The buffer that receives them.
+     * @return The number of elements removed.
+     */
+    int dequeueMany(int k, DataPoint* out);
+
     /**
      * Returns, but does not remove, the element that is frontmost.
      *
@@ -71,12 +153,68 @@ public:
     int size() const;
 
     /**
-     * Removes all elements from the priority queue.
+     * Removes all elements from the priority queue. The array keeps its
+     * current capacity; call shrinkToFit afterwards to release it.
      *
      * This operation runs in time O(1).
      */
     void clear();
 
+    /**
+     * Makes sure the array has room for at least capacity elements, so that
+     * a known number of enqueues never resizes it. The capacity also becomes
+     * the floor below which the array does not shrink automatically.
+     *
+     * This operation runs in time O(n) if the array is replaced.
+     *
+     * @param capacity The number of elements to make room for.
+     */
+    void reserve(int capacity);
+
+    /**
+     * Replaces the array by one just big enough for the current elements and
+     * cancels any earlier reserve.
+     *
+     * This operation runs in time O(n).
+     */
+    void shrinkToFit();
+
+    /**
+     * Sets the factor the array grows by when it is full (2 by default). The
+     * same factor sets when dequeue shrinks it, see shrunkCapacity in
+     * pqresize.h. If factor is not greater than 1, this function calls error().
+     *
+     * @param factor The new growth factor.
+     */
+    void setGrowthFactor(double factor);
+
+    /**
+     * Turns automatic shrinking on dequeue on (the default) or off. With it
+     * on, dequeue may replace the array by a smaller one, which keeps its
+     * amortized running time O(1).
+     *
+     * @param enabled Whether dequeue may shrink the array.
+     */
+    void setShrinkOnDequeue(bool enabled);
+
+    /**
+     * Returns the number of times the array has been replaced and the number
+     * of bytes of elements moved from old arrays into new ones.
+     *
+     * @return The resize counts for this queue.
+     */
+    ResizeStats getResizeStats() const;
+
+    /**
+     * Returns the number of elements this queue has copied in, by enqueue of
+     * an lvalue, rather than moved. Each copy of a DataPoint whose name is too
+     * long for the string's own buffer allocates a new one, so the allocation
+     * benchmarks in pqclient.cpp read this count.
+     *
+     * @return The number of elements copied in.
+     */
+    long getCopyCount() const;
+
     /**
      * This function exists purely for testing purposes. You can have it do
      * whatever you'd like. We will not invoke it when grading.
@@ -98,11 +236,17 @@ private:
     DataPoint* _elements;   // dynamic array
     int _numAllocated;      // number of slots allocated in array
     int _numFilled;         // number of slots filled in arra
-    void enlargeSize();     // added by student, doubles size of array
-
-
+    int _minCapacity;       // automatic shrinking never goes below this
+    double _growthFactor;   // array grows by this factor when full
+    bool _shrinkOnDequeue;  // whether dequeue may shrink the array
+    ResizeStats _stats;     // counts of reallocations and bytes copied
+    long _numCopies;        // elements copied in rather than moved
+    std::pmr::memory_resource* _resource; // where the array comes from
+    void enlargeSize();     // added by student, grows array by the growth factor
+    void resize(int newCapacity); // moves elements to a new array of newCapacity slots
+    DataPoint* allocateElements(int count) const;        // array of count empty DataPoints from _resource
+    void freeElements(DataPoint* elements, int count) const; // destroys and returns an array to _resource
 
-    void swap(int indexA, int indexB);
 
     /* Weird C++isms: C++ loves to make copies of things, which is usually a good thing but
      * for the purposes of this assignment requires some C++ knowledge we haven't yet covered.
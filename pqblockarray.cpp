@@ -0,0 +1,230 @@
+/*
+ * File Synopsis:
+ * This file implements BlockPQArray, the sorted-array priority queue of PQArray cut into blocks of about
+ * sqrt(n) elements, so that enqueue shifts one block instead of the whole array. The tests are at the
+ * bottom of the file; the time trials against PQArray are in pqarray.cpp.
+ */
+
+#include "pqblockarray.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include "pqarray.h"
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include "datapoint.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/*
+ * The order each block, and the sequence of blocks, is kept in: larger priority values first, so that
+ * the most urgent element is the last one of the last block.
+ */
+static bool largerPriorityFirst(const DataPoint& a, const DataPoint& b) {
+    return a.priority > b.priority;
+}
+
+BlockPQArray::BlockPQArray() {
+    _numFilled = 0;
+}
+
+/*
+ * Function Synopsis:
+ * maxBlockSize is twice the target block size, which is the square root of the number of elements but
+ * never less than MIN_BLOCK_SIZE. Blocks are split when they pass it, so there are about sqrt(n) blocks
+ * of about sqrt(n) elements.
+ */
+int BlockPQArray::maxBlockSize() const {
+    return 2 * max(MIN_BLOCK_SIZE, int(sqrt(double(_numFilled))));
+}
+
+/*
+ * Function Synopsis:
+ * splitBlock moves the back half of the block at index into a new block inserted right after it. Both
+ * halves stay in order and the new block comes between the old one and its successor, so the blocks as
+ * a whole stay in order. The new block gets room to grow to the maximum size without reallocating.
+ * No value is returned.
+ */
+void BlockPQArray::splitBlock(int index) {
+    vector<DataPoint>& full = _blocks[index];
+    int half = int(full.size()) / 2;
+    vector<DataPoint> back;
+    back.reserve(maxBlockSize() + 1);
+    back.insert(back.end(), make_move_iterator(full.begin() + half), make_move_iterator(full.end()));
+    full.erase(full.begin() + half, full.end());
+    _blocks.insert(_blocks.begin() + index + 1, std::move(back));
+}
+
+/*
+ * Function Synopsis:
+ * The enqueue functions copy or move their parameter into the queue. The last element of each block is
+ * its smallest priority, so a binary search over the blocks finds the first one whose last element is
+ * less urgent than the new element; if there is none, the new element belongs at the end of the last
+ * block. A second binary search finds its slot within the block, after any elements of equal priority,
+ * and only the rest of that block is shifted to make room. No value is returned.
+ */
+void BlockPQArray::enqueue(const DataPoint& elem) {
+    enqueue(DataPoint(elem));
+}
+
+void BlockPQArray::enqueue(DataPoint&& elem) {
+    if (_blocks.empty()) {
+        _blocks.emplace_back();
+        _blocks.back().reserve(maxBlockSize() + 1);
+    }
+    auto block = partition_point(_blocks.begin(), _blocks.end() - 1, [&elem](const vector<DataPoint>& b) {
+        return b.back().priority >= elem.priority;
+    });
+    auto slot = upper_bound(block->begin(), block->end(), elem, largerPriorityFirst);
+    block->insert(slot, std::move(elem));
+    _numFilled++;
+    if (int(block->size()) > maxBlockSize()) {
+        splitBlock(int(block - _blocks.begin()));
+    }
+}
+
+void BlockPQArray::emplace(string name, double priority) {
+    enqueue(DataPoint{ std::move(name), priority });
+}
+
+/*
+ * Function Synopsis:
+ * dequeue moves out the last element of the last block and drops that block if it is now empty, so
+ * that every block left has a last element for enqueue to search on.
+ */
+DataPoint BlockPQArray::dequeue() {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    vector<DataPoint>& last = _blocks.back();
+    DataPoint front = std::move(last.back());
+    last.pop_back();
+    if (last.empty()) {
+        _blocks.pop_back();
+    }
+    _numFilled--;
+    return front;
+}
+
+DataPoint BlockPQArray::peek() const {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    return _blocks.back().back();
+}
+
+bool BlockPQArray::isEmpty() const {
+    return size() == 0;
+}
+
+int BlockPQArray::size() const {
+    return _numFilled;
+}
+
+int BlockPQArray::numBlocks() const {
+    return int(_blocks.size());
+}
+
+void BlockPQArray::clear() {
+    _blocks.clear();
+    _numFilled = 0;
+}
+
+/*
+ * Prints the contents of each block, numbering elements as if the blocks were one array.
+ */
+void BlockPQArray::printDebugInfo(string msg) const {
+    cout << msg << endl;
+    int index = 0;
+    for (int b = 0; b < numBlocks(); b++) {
+        cout << "block " << b << ":" << endl;
+        for (const DataPoint& dp : _blocks[b]) {
+            cout << "[" << index++ << "] = " << dp << endl;
+        }
+    }
+}
+
+void BlockPQArray::validateInternalState() const {
+    int count = 0;
+    for (int b = 0; b < numBlocks(); b++) {
+        const vector<DataPoint>& block = _blocks[b];
+        if (block.empty()) error("Block " + integerToString(b) + " is empty.");
+        for (int i = 1; i < int(block.size()); i++) {
+            if (block[i].priority > block[i-1].priority) {
+                printDebugInfo("validateInternalState");
+                error("Block " + integerToString(b) + " has elements out of order at index " + integerToString(i));
+            }
+        }
+        if (b > 0 && block.front().priority > _blocks[b-1].back().priority) {
+            printDebugInfo("validateInternalState");
+            error("Block " + integerToString(b) + " is out of order with the block before it.");
+        }
+        count += int(block.size());
+    }
+    if (count != _numFilled) error("The blocks hold a different number of elements than counted.");
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("BlockPQArray: example from writeup, validate each step") {
+    BlockPQArray pq;
+    Vector<DataPoint> input = {
+        { "R", 4 }, { "A", 5 }, { "B", 3 }, { "K", 7 }, { "G", 2 },
+        { "V", 9 }, { "T", 1 }, { "O", 8 }, { "S", 6 } };
+
+    pq.validateInternalState();
+    for (DataPoint dp : input) {
+        pq.enqueue(dp);
+        pq.validateInternalState();
+    }
+    DataPoint expectedFront = { "T", 1 };
+    EXPECT_EQUAL(pq.peek(), expectedFront);
+    EXPECT_EQUAL(pq.size(), 9);
+    for (int expected = 1; expected <= 9; expected++) {
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+        pq.validateInternalState();
+    }
+    EXPECT(pq.isEmpty());
+    EXPECT_EQUAL(pq.numBlocks(), 0);
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peek());
+}
+
+STUDENT_TEST("BlockPQArray: splits into about sqrt(n) blocks, dequeues in the same order as PQArray") {
+    BlockPQArray blocks;
+    PQArray array;
+    setRandomSeed(21);
+    for (int i = 0; i < 20000; i++) {
+        DataPoint dp = { integerToString(i), double(randomInteger(0, 500)) };  // many ties
+        blocks.enqueue(dp);
+        array.enqueue(dp);
+        if (i % 3 == 2) {
+            EXPECT_EQUAL(blocks.dequeue(), array.dequeue());
+        }
+    }
+    blocks.validateInternalState();
+    EXPECT_EQUAL(blocks.size(), array.size());
+    int root = int(sqrt(double(blocks.size())));
+    EXPECT(blocks.numBlocks() >= root / 2 && blocks.numBlocks() <= 2 * root);
+    while (!array.isEmpty()) {
+        EXPECT_EQUAL(blocks.dequeue(), array.dequeue());
+    }
+    EXPECT(blocks.isEmpty());
+    blocks.validateInternalState();
+}
+
+STUDENT_TEST("BlockPQArray: clear, then reuse") {
+    BlockPQArray pq;
+    for (int i = 0; i < 1000; i++) {
+        pq.emplace("", 1000 - i);
+    }
+    EXPECT(pq.numBlocks() > 1);
+    pq.clear();
+    EXPECT(pq.isEmpty());
+    EXPECT_EQUAL(pq.numBlocks(), 0);
+    pq.validateInternalState();
+    pq.emplace("again", 3);
+    EXPECT_EQUAL(pq.dequeue().name, "again");
+}
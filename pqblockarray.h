@@ -0,0 +1,122 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+
+/**
+ * Priority queue of DataPoints implemented using a sorted array cut into
+ * blocks. It keeps the same order as PQArray, larger priority values first
+ * and the most urgent element last, but the array is split into a sequence
+ * of separately allocated blocks of about sqrt(n) elements each.
+ *
+ * enqueue finds the block the new element belongs in by binary search on the
+ * last element of each block, then inserts it into that block alone, so it
+ * moves O(sqrt n) elements instead of the O(n) that PQArray moves. A block
+ * that grows past twice the target size is split in two. dequeue takes the
+ * last element of the last block, as PQArray takes the last element of its
+ * array, and drops the block once it is empty.
+ */
+class BlockPQArray {
+public:
+    /**
+     * Creates a new, empty priority queue.
+     */
+    BlockPQArray();
+
+    /**
+     * Adds a new element into the queue. This operation runs in time
+     * O(sqrt n), where n is the number of elements in the queue.
+     *
+     * @param element The element to add.
+     */
+    void enqueue(const DataPoint& element);
+
+    /**
+     * Adds a new element into the queue, moving it in rather than copying it.
+     * This operation runs in time O(sqrt n).
+     *
+     * @param element The element to add, which is left in a moved-from state.
+     */
+    void enqueue(DataPoint&& element);
+
+    /**
+     * Adds a new element with the given name and priority into the queue
+     * without the caller having to build a DataPoint first.
+     * This operation runs in time O(sqrt n).
+     *
+     * @param name The name of the new element.
+     * @param priority The priority of the new element.
+     */
+    void emplace(std::string name, double priority);
+
+    /**
+     * Removes and returns the element that is frontmost in this priority
+     * queue. Among elements of equal priority, the one enqueued last leaves
+     * first, as in PQArray.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(1).
+     *
+     * @return The frontmost element, which is removed from queue.
+     */
+    DataPoint dequeue();
+
+    /**
+     * Returns, but does not remove, the element that is frontmost.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(1).
+     *
+     * @return frontmost element
+     */
+    DataPoint peek() const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Returns the number of blocks the elements are stored in.
+     */
+    int numBlocks() const;
+
+    /**
+     * Removes all elements from the priority queue and frees every block.
+     */
+    void clear();
+
+    /*
+     * This function exists purely for testing purposes. It prints the
+     * contents of each block.
+     */
+    void printDebugInfo(std::string msg) const;
+
+    /*
+     * This function exits purely for testing purposes. It verifies that no
+     * block is empty, that each block is in order, that every element of a
+     * block has at least the priority of every element of the next block, and
+     * that the blocks hold as many elements as counted.
+     * If a problem is detected, this function calls error().
+     */
+    void validateInternalState() const;
+
+private:
+    static const int MIN_BLOCK_SIZE = 32; // target block size for small queues
+
+    std::vector<std::vector<DataPoint>> _blocks; // nonempty blocks, larger priorities first
+    int _numFilled;                              // number of elements in all the blocks
+
+    int maxBlockSize() const;        // size past which a block is split
+    void splitBlock(int index);      // moves the back half of a block into a new block after it
+
+    DISALLOW_COPYING_OF(BlockPQArray);
+};
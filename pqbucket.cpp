@@ -0,0 +1,106 @@
+/*
+ * File Synopsis:
+ * The bucket queue keeps one first-in first-out list for each whole-number priority in a range declared
+ * when it is created, and sends any other priority to a PQHeap alongside. It is a class template, so its
+ * implementation lives in pqbucket.h. This file instantiates the DataPoint queue (BucketPQueue) and
+ * contains its tests; the time trial against PQHeap is in pqclient.cpp.
+ */
+
+#include "pqbucket.h"
+#include <algorithm>
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include "datapoint.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/* The DataPoint queue is instantiated here so that every member function is compiled
+ * even if no test happens to call it.
+ */
+template class BasicBucketPQueue<DataPoint, DataPointPriority>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("BucketPQueue: example from writeup, validate each step") {
+    BucketPQueue pq(1, 9);
+    Vector<DataPoint> input = {
+        { "R", 4 }, { "A", 5 }, { "B", 3 }, { "K", 7 }, { "G", 2 },
+        { "V", 9 }, { "T", 1 }, { "O", 8 }, { "S", 6 } };
+
+    pq.validateInternalState();
+    for (DataPoint dp : input) {
+        pq.enqueue(dp);
+        pq.validateInternalState();
+    }
+    DataPoint expectedFront = { "T", 1 };
+    EXPECT_EQUAL(pq.peek(), expectedFront);
+    EXPECT_EQUAL(pq.fallbackSize(), 0);
+    for (int expected = 1; expected <= 9; expected++) {
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+        pq.validateInternalState();
+    }
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peek());
+    EXPECT_ERROR(BucketPQueue(5, 4));
+}
+
+STUDENT_TEST("BucketPQueue: equal priorities dequeue first in, first out") {
+    BucketPQueue pq(0, 3);
+    for (int i = 0; i < 40; i++) {
+        pq.emplace(integerToString(i), double(i % 4));
+    }
+    pq.validateInternalState();
+    for (int priority = 0; priority <= 3; priority++) {
+        for (int i = priority; i < 40; i += 4) {
+            DataPoint expected = { integerToString(i), double(priority) };
+            EXPECT_EQUAL(pq.dequeue(), expected);
+        }
+    }
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("BucketPQueue: out-of-range and fractional priorities use the fallback heap") {
+    BucketPQueue pq(1, 10);
+    Vector<double> priorities = { 5, -3, 10, 2.5, 11, 1, 0, 5, 1e9, 10.0001 };
+    for (double priority : priorities) {
+        pq.enqueue({ "", priority });
+    }
+    EXPECT_EQUAL(pq.fallbackSize(), 6);
+    EXPECT_EQUAL(pq.size(), priorities.size());
+    pq.validateInternalState();
+    sort(priorities.begin(), priorities.end());
+    for (double expected : priorities) {
+        EXPECT_EQUAL(pq.peek().priority, expected);
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+        pq.validateInternalState();
+    }
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("BasicBucketPQueue: random operations against sorted order, growth and clear") {
+    BasicBucketPQueue<int> pq(-50, 50);
+    Vector<int> model;
+    setRandomSeed(31);
+    for (int step = 0; step < 5000; step++) {
+        if (model.isEmpty() || randomChance(0.55)) {
+            int value = randomInteger(-80, 80);     // some fall outside the buckets
+            pq.enqueue(value);
+            model.add(value);
+        } else {
+            int smallest = *min_element(model.begin(), model.end());
+            EXPECT_EQUAL(pq.dequeue(), smallest);
+            model.remove(int(find(model.begin(), model.end(), smallest) - model.begin()));
+        }
+        EXPECT_EQUAL(pq.size(), model.size());
+        if (step % 100 == 0) {
+            pq.validateInternalState();
+        }
+    }
+    pq.clear();
+    pq.validateInternalState();
+    EXPECT(pq.isEmpty());
+    pq.enqueue(7);
+    EXPECT_EQUAL(pq.peek(), 7);
+}
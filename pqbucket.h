@@ -0,0 +1,411 @@
+#pragma once
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "strlib.h"
+#include "pqheap.h"
+
+/**
+ * Priority queue of elements of type T for workloads whose priorities are
+ * mostly whole numbers in a small range declared up front, such as 1 through
+ * 10. Smallest priority is frontmost, as for PQHeap.
+ *
+ * Every whole number in the range has its own bucket, a first-in first-out
+ * list, so enqueue is O(1) and elements of equal priority in the range come
+ * out in the order they went in. A cursor remembers the lowest nonempty
+ * bucket; dequeue takes from it and moves it forward past buckets that have
+ * emptied. Since the cursor moves back only when an enqueue is below it, a
+ * queue whose new priorities are rarely below its front (a calendar queue)
+ * dequeues in amortized O(1), and a dequeue never costs more than a scan of
+ * the range.
+ *
+ * Priorities outside the range, or not whole numbers, go to a BasicPQHeap
+ * kept alongside the buckets, and dequeue takes whichever front is more
+ * urgent, so any priority is accepted; only the in-range ones are fast and
+ * in FIFO order.
+ *
+ * The nodes of all the bucket lists share one array and link to each other
+ * by index, so the queue allocates only when that array grows.
+ */
+template <typename T, typename KeyFn = IdentityKey>
+class BasicBucketPQueue {
+public:
+    /* The type of priority that KeyFn reads from an element. */
+    using Key = std::decay_t<decltype(std::declval<KeyFn>()(std::declval<const T&>()))>;
+
+    /**
+     * Creates a new, empty priority queue with one bucket for every whole
+     * number from lowest through highest. If highest is less than lowest, or
+     * the range has more than MAX_BUCKETS numbers, this function calls error().
+     *
+     * @param lowest The smallest priority that gets a bucket.
+     * @param highest The largest priority that gets a bucket.
+     */
+    BasicBucketPQueue(int lowest, int highest);
+
+    /**
+     * Cleans up all memory allocated by this priority queue.
+     */
+    ~BasicBucketPQueue();
+
+    /**
+     * Adds a new element into the queue. This operation runs in time O(1)
+     * for a priority in the range and O(log n) otherwise.
+     *
+     * @param element The element to add.
+     */
+    void enqueue(const T& element);
+    void enqueue(T&& element);
+
+    /**
+     * Adds a new element into the queue, constructing it from the given
+     * arguments.
+     *
+     * @param args The arguments used to brace-initialize the element.
+     */
+    template <typename... Args>
+    void emplace(Args&&... args);
+
+    /**
+     * Removes and returns the element that is frontmost in this priority queue.
+     * Elements with the same priority in the range are dequeued in the order
+     * they were enqueued.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in amortized time O(1) for a calendar workload, and
+     * at most O(range) for a bucket or O(log n) for an out-of-range element.
+     *
+     * @return The frontmost element, which is removed from queue.
+     */
+    T dequeue();
+
+    /**
+     * Returns, but does not remove, the element that is frontmost.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(1).
+     *
+     * @return frontmost element
+     */
+    T peek() const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Returns how many of the elements are in the fallback heap because their
+     * priorities are outside the range or not whole numbers.
+     */
+    int fallbackSize() const;
+
+    /**
+     * Removes all elements from the priority queue. This operation runs in
+     * time O(range + capacity).
+     */
+    void clear();
+
+    /*
+     * This function exists purely for testing purposes. It prints the
+     * contents of every nonempty bucket, then the fallback heap.
+     */
+    void printDebugInfo(std::string msg) const;
+
+    /*
+     * This function exits purely for testing purposes. It verifies that every
+     * element in a bucket has that bucket's priority, that the list links and
+     * counts agree, that no bucket below the cursor holds anything, and that
+     * the fallback heap is in order.
+     * If a problem is detected, this function calls error().
+     */
+    void validateInternalState() const;
+
+    /* The largest number of buckets a queue may declare. */
+    static constexpr int MAX_BUCKETS = 1 << 24;
+
+private:
+    static constexpr int INITIAL_CAPACITY = 10;
+    static constexpr int NONE = -1; // an absent link or empty bucket
+
+    int _lowest;            // priority of bucket 0
+    int _numBuckets;        // number of whole numbers in the range
+    int* _heads;            // _heads[b] is the first node of bucket b, or NONE
+    int* _tails;            // _tails[b] is the last node of bucket b, or NONE
+    int _cursor;            // no bucket below this one holds an element
+    int _numInBuckets;      // number of elements in all the buckets
+
+    T* _payloads;           // elements, one per node
+    int* _next;             // next node in the same bucket, or in the free list
+    int _freeList;          // first unused node, or NONE
+    int _numAllocated;      // number of nodes allocated
+
+    BasicPQHeap<T, std::less<>, KeyFn> _fallback; // elements whose priorities have no bucket
+    KeyFn _key;             // reads the priority of an element
+
+    int bucketOf(const Key& key) const;   // bucket of a priority, or NONE for the fallback
+    void enlargeNodes();
+    bool frontIsInBucket() const;         // whether the frontmost element is in a bucket
+
+    DISALLOW_COPYING_OF(BasicBucketPQueue);
+};
+
+/*
+ * The allocator sets up empty buckets for the range and a free list holding
+ * every node.
+ */
+template <typename T, typename KeyFn>
+BasicBucketPQueue<T, KeyFn>::BasicBucketPQueue(int lowest, int highest) {
+    if (highest < lowest || (long long) highest - lowest + 1 > MAX_BUCKETS) {
+        error("Bucket range must be nonempty and hold at most " + integerToString(MAX_BUCKETS) + " priorities");
+    }
+    _lowest = lowest;
+    _numBuckets = highest - lowest + 1;
+    _heads = new int[_numBuckets];
+    _tails = new int[_numBuckets];
+    for (int b = 0; b < _numBuckets; b++) {
+        _heads[b] = NONE;
+        _tails[b] = NONE;
+    }
+    _cursor = _numBuckets;
+    _numInBuckets = 0;
+
+    _numAllocated = INITIAL_CAPACITY;
+    _payloads = new T[_numAllocated]();
+    _next = new int[_numAllocated];
+    for (int i = 0; i < _numAllocated; i++) {
+        _next[i] = i + 1 < _numAllocated ? i + 1 : NONE;
+    }
+    _freeList = 0;
+}
+
+template <typename T, typename KeyFn>
+BasicBucketPQueue<T, KeyFn>::~BasicBucketPQueue() {
+    delete[] _heads;
+    delete[] _tails;
+    delete[] _payloads;
+    delete[] _next;
+}
+
+/*
+ * Private helper that returns the bucket of a priority, or NONE if it is not
+ * a whole number in the range (a NaN fails both comparisons and gets NONE).
+ */
+template <typename T, typename KeyFn>
+int BasicBucketPQueue<T, KeyFn>::bucketOf(const Key& key) const {
+    if (!(key >= _lowest && key <= _lowest + (_numBuckets - 1))) {
+        return NONE;
+    }
+    long long whole = (long long) key;
+    if (whole != key) {
+        return NONE;
+    }
+    return int(whole - _lowest);
+}
+
+/*
+ * Private helper that doubles the node arrays. It is only called when the free
+ * list is empty, so the new free list is exactly the nodes past the old ones.
+ */
+template <typename T, typename KeyFn>
+void BasicBucketPQueue<T, KeyFn>::enlargeNodes() {
+    int newAllocated = _numAllocated * 2;
+    T* newPayloads = new T[newAllocated]();
+    int* newNext = new int[newAllocated];
+    for (int i = 0; i < _numAllocated; i++) {
+        newPayloads[i] = std::move(_payloads[i]);
+        newNext[i] = _next[i];
+    }
+    for (int i = _numAllocated; i < newAllocated; i++) {
+        newNext[i] = i + 1 < newAllocated ? i + 1 : NONE;
+    }
+    delete[] _payloads;
+    delete[] _next;
+    _payloads = newPayloads;
+    _next = newNext;
+    _freeList = _numAllocated;
+    _numAllocated = newAllocated;
+}
+
+template <typename T, typename KeyFn>
+void BasicBucketPQueue<T, KeyFn>::enqueue(const T& element) {
+    enqueue(T(element));
+}
+
+/*
+ * An element with a bucket takes a node from the free list and is appended to
+ * the tail of its bucket; the cursor moves back if the bucket is below it.
+ */
+template <typename T, typename KeyFn>
+void BasicBucketPQueue<T, KeyFn>::enqueue(T&& element) {
+    int bucket = bucketOf(_key(element));
+    if (bucket == NONE) {
+        _fallback.enqueue(std::move(element));
+        return;
+    }
+    if (_freeList == NONE) {
+        enlargeNodes();
+    }
+    int node = _freeList;
+    _freeList = _next[node];
+    _payloads[node] = std::move(element);
+    _next[node] = NONE;
+    if (_tails[bucket] == NONE) {
+        _heads[bucket] = node;
+    } else {
+        _next[_tails[bucket]] = node;
+    }
+    _tails[bucket] = node;
+    _numInBuckets++;
+    _cursor = std::min(_cursor, bucket);
+}
+
+template <typename T, typename KeyFn>
+template <typename... Args>
+void BasicBucketPQueue<T, KeyFn>::emplace(Args&&... args) {
+    enqueue(buildElement<T>(std::forward<Args>(args)...));
+}
+
+/*
+ * Private helper: the front is in a bucket unless the buckets are empty or the
+ * fallback heap's front is strictly more urgent than the cursor's bucket.
+ */
+template <typename T, typename KeyFn>
+bool BasicBucketPQueue<T, KeyFn>::frontIsInBucket() const {
+    if (_numInBuckets == 0) {
+        return false;
+    }
+    return _fallback.isEmpty() || !(_key(_fallback.peek()) < _key(_payloads[_heads[_cursor]]));
+}
+
+/*
+ * The head of the cursor's bucket is unlinked and its node returned to the
+ * free list; if the bucket is now empty the cursor moves forward to the next
+ * nonempty one.
+ */
+template <typename T, typename KeyFn>
+T BasicBucketPQueue<T, KeyFn>::dequeue() {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    if (!frontIsInBucket()) {
+        return _fallback.dequeue();
+    }
+    int node = _heads[_cursor];
+    T front = std::move(_payloads[node]);
+    _heads[_cursor] = _next[node];
+    if (_heads[_cursor] == NONE) {
+        _tails[_cursor] = NONE;
+    }
+    _next[node] = _freeList;
+    _freeList = node;
+    _numInBuckets--;
+    if (_numInBuckets == 0) {
+        _cursor = _numBuckets;
+    } else {
+        while (_heads[_cursor] == NONE) {
+            _cursor++;
+        }
+    }
+    return front;
+}
+
+template <typename T, typename KeyFn>
+T BasicBucketPQueue<T, KeyFn>::peek() const {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    return frontIsInBucket() ? _payloads[_heads[_cursor]] : _fallback.peek();
+}
+
+template <typename T, typename KeyFn>
+bool BasicBucketPQueue<T, KeyFn>::isEmpty() const {
+    return size() == 0;
+}
+
+template <typename T, typename KeyFn>
+int BasicBucketPQueue<T, KeyFn>::size() const {
+    return _numInBuckets + _fallback.size();
+}
+
+template <typename T, typename KeyFn>
+int BasicBucketPQueue<T, KeyFn>::fallbackSize() const {
+    return _fallback.size();
+}
+
+template <typename T, typename KeyFn>
+void BasicBucketPQueue<T, KeyFn>::clear() {
+    for (int b = 0; b < _numBuckets; b++) {
+        _heads[b] = NONE;
+        _tails[b] = NONE;
+    }
+    for (int i = 0; i < _numAllocated; i++) {
+        _next[i] = i + 1 < _numAllocated ? i + 1 : NONE;
+    }
+    _freeList = 0;
+    _cursor = _numBuckets;
+    _numInBuckets = 0;
+    _fallback.clear();
+}
+
+template <typename T, typename KeyFn>
+void BasicBucketPQueue<T, KeyFn>::printDebugInfo(std::string msg) const {
+    std::cout << msg << " (cursor at priority " << _lowest + _cursor << ")" << std::endl;
+    for (int b = 0; b < _numBuckets; b++) {
+        if (_heads[b] != NONE) {
+            std::cout << "bucket " << _lowest + b << ":";
+            for (int node = _heads[b]; node != NONE; node = _next[node]) {
+                std::cout << " " << _payloads[node];
+            }
+            std::cout << std::endl;
+        }
+    }
+    _fallback.printDebugInfo("fallback heap");
+}
+
+template <typename T, typename KeyFn>
+void BasicBucketPQueue<T, KeyFn>::validateInternalState() const {
+    int count = 0;
+    for (int b = 0; b < _numBuckets; b++) {
+        if ((_heads[b] == NONE) != (_tails[b] == NONE)) {
+            error("Bucket " + integerToString(_lowest + b) + " has a head without a tail or a tail without a head.");
+        }
+        if (_heads[b] != NONE && b < _cursor) {
+            error("Bucket " + integerToString(_lowest + b) + " is below the cursor but not empty.");
+        }
+        int last = NONE;
+        for (int node = _heads[b]; node != NONE; node = _next[node]) {
+            if (++count > _numInBuckets) error("The buckets hold more elements than counted.");
+            if (bucketOf(_key(_payloads[node])) != b) {
+                error("An element in bucket " + integerToString(_lowest + b) + " has a different priority.");
+            }
+            last = node;
+        }
+        if (last != _tails[b]) {
+            error("The tail of bucket " + integerToString(_lowest + b) + " is not its last node.");
+        }
+    }
+    if (count != _numInBuckets) error("The buckets hold fewer elements than counted.");
+    if (_numInBuckets > 0 && (_cursor >= _numBuckets || _heads[_cursor] == NONE)) {
+        error("The cursor is not at the lowest nonempty bucket.");
+    }
+    _fallback.validateInternalState();
+}
+
+/**
+ * Priority queue of DataPoints with a bucket for each whole-number priority
+ * in a declared range.
+ */
+using BucketPQueue = BasicBucketPQueue<DataPoint, DataPointPriority>;
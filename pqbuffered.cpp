@@ -0,0 +1,106 @@
+/*
+ * File Synopsis:
+ * The buffered heap puts a lock-free list in front of a PQHeap so that producer threads never wait on
+ * the heap; the single consumer moves whatever has been pushed into the heap in one batch. It is a class
+ * template, so its implementation lives in pqbuffered.h. This file instantiates the DataPoint queue
+ * (BufferedPQHeap) and contains its tests; the producer/consumer time trial is in pqclient.cpp.
+ */
+
+#include "pqbuffered.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include "datapoint.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/* The DataPoint queue is instantiated here so that every member function is compiled
+ * even if no test happens to call it.
+ */
+template class BasicBufferedPQHeap<DataPoint, std::less<>, DataPointPriority>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("BufferedPQHeap: example from writeup, validate each step") {
+    BufferedPQHeap pq;
+    Vector<DataPoint> input = {
+        { "R", 4 }, { "A", 5 }, { "B", 3 }, { "K", 7 }, { "G", 2 },
+        { "V", 9 }, { "T", 1 }, { "O", 8 }, { "S", 6 } };
+
+    pq.validateInternalState();
+    for (DataPoint dp : input) {
+        pq.enqueue(dp);
+        pq.validateInternalState();
+    }
+    EXPECT_EQUAL(pq.bufferedSize(), 9);
+    DataPoint expectedFront = { "T", 1 };
+    EXPECT_EQUAL(pq.peek(), expectedFront);
+    EXPECT_EQUAL(pq.bufferedSize(), 0);
+    EXPECT_EQUAL(pq.size(), 9);
+    for (int expected = 1; expected <= 9; expected++) {
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+        pq.validateInternalState();
+    }
+    DataPoint unused;
+    EXPECT(!pq.tryDequeue(unused));
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peek());
+}
+
+STUDENT_TEST("BufferedPQHeap: batches of every size interleaved with dequeues") {
+    BufferedPQHeap pq;
+    Vector<double> all;   // priorities not yet dequeued, kept sorted
+    setRandomSeed(19);
+    for (int batchSize : { 3, 1, 500, 2, 0, 50, 5000, 10 }) {
+        for (int i = 0; i < batchSize; i++) {
+            double priority = randomInteger(0, 1000);
+            pq.emplace("", priority);
+            all.insert(int(upper_bound(all.begin(), all.end(), priority) - all.begin()), priority);
+        }
+        EXPECT_EQUAL(pq.size(), all.size());
+        for (int i = 0; i < 3 && !all.isEmpty(); i++) {
+            EXPECT_EQUAL(pq.dequeue().priority, all[0]);
+            all.remove(0);
+        }
+        pq.validateInternalState();
+    }
+    pq.enqueue({ "left in the buffer", 1 });
+    pq.clear();
+    EXPECT(pq.isEmpty());
+    pq.validateInternalState();
+}
+
+STUDENT_TEST("BufferedPQHeap: many producers and a consumer lose and duplicate nothing") {
+    const int numProducers = 4;
+    const int perProducer = 20000;
+    BufferedPQHeap pq;
+    vector<thread> producers;
+    for (int t = 0; t < numProducers; t++) {
+        producers.push_back(thread([&pq, t]() {
+            for (int i = 0; i < perProducer; i++) {
+                pq.emplace("", double(i * numProducers + t));
+            }
+        }));
+    }
+    Vector<int> timesSeen(numProducers * perProducer, 0);
+    int taken = 0;
+    DataPoint front;
+    while (taken < numProducers * perProducer) {
+        if (pq.tryDequeue(front)) {
+            timesSeen[int(front.priority)]++;
+            taken++;
+        }
+    }
+    for (thread& producer : producers) {
+        producer.join();
+    }
+    EXPECT(pq.isEmpty());
+    for (int count : timesSeen) {
+        EXPECT_EQUAL(count, 1);
+    }
+}
@@ -0,0 +1,303 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "strlib.h"
+#include "pqheap.h"
+
+/**
+ * Priority queue of elements of type T for many producer threads and one
+ * consumer thread. Producers never touch the heap: enqueue pushes onto a
+ * lock-free list, and the consumer moves everything pushed so far into a
+ * BasicPQHeap in one batch the next time it looks at the front.
+ *
+ * enqueue (and emplace) may be called from any number of threads at once.
+ * Each pushes a node onto the front of a singly linked list with a single
+ * compare-and-swap, retried only if another producer pushed in between, so no
+ * producer ever waits for a lock or for the consumer.
+ *
+ * Every other member function belongs to the consumer and must only be called
+ * from one thread at a time. Before peek, dequeue and the like, the consumer
+ * takes the whole list with one atomic exchange and hands the batch to the
+ * heap's enqueueAll, which sifts small batches in and rebuilds the heap
+ * bottom-up for large ones. Draining has no races with producers: they only
+ * ever see an empty or nonempty list head.
+ *
+ * The template parameters mean the same as for BasicPQHeap.
+ */
+template <typename T, typename Compare = std::less<>, typename KeyFn = IdentityKey, int Arity = 2>
+class BasicBufferedPQHeap {
+public:
+    /**
+     * Creates a new, empty priority queue.
+     */
+    BasicBufferedPQHeap() = default;
+
+    /**
+     * Creates a new, empty priority queue whose heap has room for capacity
+     * elements allocated up front.
+     *
+     * @param capacity The number of slots to allocate.
+     */
+    BasicBufferedPQHeap(int capacity) : _heap(capacity) {}
+
+    /**
+     * Cleans up all memory allocated by this priority queue, including
+     * elements still in the buffer.
+     */
+    ~BasicBufferedPQHeap();
+
+    /**
+     * Adds a new element to the buffer. Any thread may call this at any time.
+     * This operation runs in time O(1) plus one allocation, and is lock-free.
+     *
+     * @param element The element to add.
+     */
+    void enqueue(const T& element);
+    void enqueue(T&& element);
+
+    /**
+     * Adds a new element to the buffer, constructing it from the given
+     * arguments. Any thread may call this at any time.
+     *
+     * @param args The arguments used to brace-initialize the element.
+     */
+    template <typename... Args>
+    void emplace(Args&&... args);
+
+    /**
+     * Moves every buffered element into the heap. The queries below do this
+     * themselves; calling it directly lets the consumer do the work at a
+     * convenient moment. This operation runs in time O(k log n) or O(n + k)
+     * for k buffered elements, whichever enqueueAll picks.
+     */
+    void flush();
+
+    /**
+     * Removes and returns the element that is frontmost in this priority
+     * queue, including everything enqueued before the call.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * @return The frontmost element, which is removed from queue.
+     */
+    T dequeue();
+
+    /**
+     * Removes the frontmost element and moves it into front, or returns false
+     * and leaves front alone if the queue is empty.
+     *
+     * @param front Receives the frontmost element.
+     * @return Whether an element was dequeued.
+     */
+    bool tryDequeue(T& front);
+
+    /**
+     * Returns, but does not remove, the element that is frontmost.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * @return frontmost element
+     */
+    T peek();
+
+    /**
+     * Returns whether this priority queue, buffer included, is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue, buffer included.
+     */
+    int size() const;
+
+    /**
+     * Returns the count of elements still in the buffer.
+     */
+    int bufferedSize() const;
+
+    /**
+     * Removes all elements from the priority queue and the buffer.
+     */
+    void clear();
+
+    /*
+     * This function exists purely for testing purposes. It prints the
+     * buffered elements, newest first, then the heap.
+     */
+    void printDebugInfo(std::string msg) const;
+
+    /*
+     * This function exits purely for testing purposes. It verifies that
+     * the heap is in order and that the buffer holds as many elements as
+     * counted. No producer may enqueue meanwhile.
+     * If a problem is detected, this function calls error().
+     */
+    void validateInternalState() const;
+
+private:
+    /* A buffered element and the one pushed before it. */
+    struct Node {
+        T element;
+        Node* next;
+    };
+
+    std::atomic<Node*> _head{nullptr};   // most recently pushed node, or nullptr
+    std::atomic<int> _numBuffered{0};    // number of nodes in the list
+    BasicPQHeap<T, Compare, KeyFn, Arity> _heap;
+    std::vector<T> _batch;               // drained elements on their way into the heap, kept for its capacity
+
+    void push(Node* node);
+    static void deleteList(Node* node);
+
+    DISALLOW_COPYING_OF(BasicBufferedPQHeap);
+};
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::~BasicBufferedPQHeap() {
+    deleteList(_head.load());
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::deleteList(Node* node) {
+    while (node != nullptr) {
+        Node* next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
+/*
+ * Private helper that links a node in front of the current head. The release
+ * ordering on success publishes the node's element to the consumer, whose
+ * exchange acquires it; on failure the head is reloaded and the link retried.
+ * The count goes up first so that a flush never takes it below zero.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::push(Node* node) {
+    _numBuffered.fetch_add(1, std::memory_order_relaxed);
+    node->next = _head.load(std::memory_order_relaxed);
+    while (!_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        // node->next now holds the head another producer pushed, try again on top of it
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::enqueue(const T& element) {
+    push(new Node{element, nullptr});
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::enqueue(T&& element) {
+    push(new Node{std::move(element), nullptr});
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+template <typename... Args>
+void BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::emplace(Args&&... args) {
+    push(new Node{buildElement<T>(std::forward<Args>(args)...), nullptr});
+}
+
+/*
+ * The whole list is detached at once, so producers carry on pushing onto a
+ * fresh one while its elements are moved into the batch and its nodes freed.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::flush() {
+    Node* node = _head.exchange(nullptr, std::memory_order_acquire);
+    if (node == nullptr) {
+        return;
+    }
+    _batch.clear();
+    while (node != nullptr) {
+        Node* next = node->next;
+        _batch.push_back(std::move(node->element));
+        delete node;
+        node = next;
+    }
+    _numBuffered.fetch_sub(int(_batch.size()), std::memory_order_relaxed);
+    _heap.enqueueAll(std::make_move_iterator(_batch.begin()), std::make_move_iterator(_batch.end()));
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+T BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::dequeue() {
+    flush();
+    return _heap.dequeue();
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+bool BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::tryDequeue(T& front) {
+    flush();
+    if (_heap.isEmpty()) {
+        return false;
+    }
+    front = _heap.dequeue();
+    return true;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+T BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::peek() {
+    flush();
+    return _heap.peek();
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+bool BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::isEmpty() const {
+    return size() == 0;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+int BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::size() const {
+    return _heap.size() + bufferedSize();
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+int BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::bufferedSize() const {
+    return _numBuffered.load(std::memory_order_relaxed);
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::clear() {
+    Node* node = _head.exchange(nullptr, std::memory_order_acquire);
+    int count = 0;
+    for (Node* counted = node; counted != nullptr; counted = counted->next) {
+        count++;
+    }
+    deleteList(node);
+    _numBuffered.fetch_sub(count, std::memory_order_relaxed);
+    _heap.clear();
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::printDebugInfo(std::string msg) const {
+    std::cout << msg << std::endl;
+    std::cout << "buffer:";
+    for (Node* node = _head.load(std::memory_order_acquire); node != nullptr; node = node->next) {
+        std::cout << " " << node->element;
+    }
+    std::cout << std::endl;
+    _heap.printDebugInfo("heap");
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicBufferedPQHeap<T, Compare, KeyFn, Arity>::validateInternalState() const {
+    int count = 0;
+    for (Node* node = _head.load(std::memory_order_acquire); node != nullptr; node = node->next) {
+        count++;
+    }
+    if (count != bufferedSize()) error("The buffer holds a different number of elements than counted.");
+    _heap.validateInternalState();
+}
+
+/**
+ * Priority queue of DataPoints, smallest priority first, with a lock-free
+ * buffer for producer threads in front of a PQHeap.
+ */
+using BufferedPQHeap = BasicBufferedPQHeap<DataPoint, std::less<>, DataPointPriority>;
@@ -10,9 +10,30 @@
 #include "pqclient.h"
 #include "pqarray.h"
 #include "pqheap.h"
+#include "arenadatapoint.h"
+#include "countingresource.h"
+#include "pqinterned.h"
+#include "pqsplitheap.h"
+#include "pqaddressable.h"
+#include "pqpairing.h"
+#include "pqradix.h"
+#include "pqbucket.h"
+#include "pqstable.h"
+#include "pqconcurrent.h"
+#include "pqmultiqueue.h"
+#include "pqbuffered.h"
+#include "datapointio.h"
 #include "vector.h"
 #include "strlib.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <random>
 #include <sstream>
+#include <thread>
 #include "testing/SimpleTest.h"
 using namespace std;
 
@@ -22,81 +43,324 @@ using namespace std;
  * to compare the efficiency of PQHeap and PQArray.
  */
 void pqSort(Vector<DataPoint>& v) {
-    PQHeap pq; //changed to answer Q14
-
     /* Using the Priority Queue data structure as a tool to sort, neat! */
 
-    /* Add all the elements to the priority queue. */
-    for (int i = 0; i < v.size(); i++) {
-        pq.enqueue(v[i]);
-    }
+    /* Build the priority queue out of all the elements at once. The array is
+     * allocated once at the right size and put in heap order bottom-up in O(n),
+     * instead of n enqueues of O(log n) each that keep doubling the array.
+     */
+    PQHeap pq(v); //changed to answer Q14
 
     /* Extract all the elements from the priority queue. Due
      * to the priority queue property, we know that we will get
      * these elements in sorted order, in order of increasing priority
-     * value. Store elements back into vector, now in sorted order.
+     * value. dequeueMany moves them straight back into the vector,
+     * now in sorted order.
      */
-    for (int i = 0; !pq.isEmpty(); i++) {
-        v[i] = pq.dequeue();
+    if (!v.isEmpty()) {
+        pq.dequeueMany(v.size(), &v[0]);
     }
 }
 
 
 
-/* Function synopsis:
- * The sortVec function is a helper function for topK which sorts the array through a series of swaps
- * when an element is just added to the vector. This function is void so it does not return any value,
- * and it takes in two parameters which are the vector of DataPoints to sort and the index of the recently
- * added data point.
+/* Function Synopsis:
+ * heapsortRange sorts the n DataPoints starting at elements into increasing order of priority without
+ * allocating any memory, by using their own storage as the priority queue (a heapsort). They are first
+ * arranged bottom-up into a heap whose front is the largest priority. Then, over and over, the front is
+ * swapped with the last element of the heap, which is its sorted position, and the heap shrinks by one
+ * and is put back in order with siftDown. Nothing is returned.
  */
-void sortVec(Vector<DataPoint>& toSort, DataPoint justAdded){
-    for(int i = toSort.size()-2; i>=0; i--){//sorts the elements in descending order
-        if(toSort[i].priority < justAdded.priority){
-            DataPoint tmp = toSort[i];
-            toSort[i] = toSort[i+1];
-            toSort[i+1] = tmp;
-        }
-        else{
-            break;
-        }
+static void heapsortRange(DataPoint* elements, int n) {
+    if (n < 2) {
+        return;
+    }
+    auto largerFirst = [](const DataPoint& a, const DataPoint& b) {
+        return a.priority > b.priority;
+    };
+    heapify(elements, n, largerFirst);
+    for (int end = n - 1; end > 0; end--) {
+        std::swap(elements[0], elements[end]);//largest remaining element goes to its final spot
+        siftDown(elements, 0, end, largerFirst);
     }
 }
+
 /* Function Synopsis:
- * firstKofTopK is a helper function for topK which takes in the first k values from the stream,
- * adds them to the vector of data points, and sorts them. The function then returns the fully sorted
- * vector of the first k amount of data points. There are two parameters which are
- * the stream that is passed by reference, and an integer that holds the value of k.
+ * pqSortInPlace sorts its parameter vector of DataPoints into increasing order of priority without
+ * allocating any memory, with a heapsort of the vector's own storage. Nothing is returned since the
+ * vector is passed by reference.
  */
-Vector<DataPoint> firstKofTopK(istream& stream, int k){
-    Vector<DataPoint> firstVals;
-    DataPoint cur;
-    while(firstVals.size()<k && stream >> cur){//adds first k vals from stream into the vector
-        firstVals.add(cur);
-        sortVec(firstVals, cur);
+void pqSortInPlace(Vector<DataPoint>& v) {
+    if (!v.isEmpty()) {
+        heapsortRange(&v[0], v.size());
+    }
+}
+
+/* The element of the merge queue in pqSortParallel: the priority at the head of a sorted run and
+ * the index of that run. It is 16 bytes, so the merge heap never moves a DataPoint. */
+struct RunHead {
+    double priority;
+    int run;
+};
+
+struct RunHeadPriority {
+    double operator()(const RunHead& head) const {
+        return head.priority;
+    }
+};
+
+/* Function Synopsis:
+ * pqSortParallel sorts its parameter vector of DataPoints into increasing order of priority using
+ * numThreads threads. The vector is cut into numThreads runs of consecutive elements, and each run is
+ * heapsorted in place by a thread of its own, the calling thread taking the first run. The sorted runs
+ * are then merged by a PQHeap that holds the head of every run that still has elements: its front
+ * names the run whose head comes next, that head is moved into the output, and the run's new head
+ * replaces the front. The merge costs O(n log numThreads) on the calling thread and one buffer of n
+ * elements, whose elements are moved back into the vector at the end. If numThreads is less than one,
+ * this function calls error(). Nothing is returned since the vector is passed by reference.
+ */
+void pqSortParallel(Vector<DataPoint>& v, int numThreads) {
+    if (numThreads < 1) {
+        error("pqSortParallel needs at least one thread");
+    }
+    int n = v.size();
+    if (n < 2) {
+        return;
+    }
+    numThreads = min(numThreads, n);
+    DataPoint* elements = &v[0];
+    vector<int> runStart(numThreads + 1);
+    for (int t = 0; t <= numThreads; t++) {
+        runStart[t] = int(long(n) * t / numThreads);
+    }
+    vector<thread> workers;
+    for (int t = 1; t < numThreads; t++) {
+        workers.push_back(thread([elements, &runStart, t]() {
+            heapsortRange(elements + runStart[t], runStart[t + 1] - runStart[t]);
+        }));
+    }
+    heapsortRange(elements, runStart[1]);
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    if (numThreads == 1) {
+        return;
     }
-    return firstVals;
+
+    BasicPQHeap<RunHead, std::less<>, RunHeadPriority> heads(numThreads);
+    vector<int> next(runStart.begin(), runStart.end() - 1);  // index of the head of each run
+    for (int run = 0; run < numThreads; run++) {
+        heads.enqueue({ elements[next[run]].priority, run });
+    }
+    vector<DataPoint> merged;
+    merged.reserve(n);
+    while (!heads.isEmpty()) {
+        int run = heads.peek().run;
+        merged.push_back(std::move(elements[next[run]]));
+        next[run]++;
+        if (next[run] < runStart[run + 1]) {
+            heads.replaceFront({ elements[next[run]].priority, run });
+        } else {
+            heads.dequeue();
+        }
+    }
+    std::move(merged.begin(), merged.end(), elements);
 }
 
 /* Function synopsis:
  * topK is a function which takes in a stream of DataPoints and an integer k. topK returns a vector
- * of the k largest priority values inputted from the stream.
+ * of the k largest priority values inputted from the stream, in descending order of priority.
+ * The k largest values seen so far are kept in a PQHeap of size k. Its frontmost element is the
+ * smallest of them, so each new value only needs to be compared against the front, and a value
+ * that makes the cut replaces the front in O(log k). The whole stream costs O(n log k). The heap
+ * starts small and grows only while it is filling, so a k larger than the stream costs no more
+ * memory than the stream's own points; once it holds k points, replaceFront keeps it at that size.
  */
 Vector<DataPoint> topK(istream& stream, int k) {
-    Vector<DataPoint> largestVals = firstKofTopK(stream, k);
+    Vector<DataPoint> largestVals;
+    if(k <= 0){
+        return largestVals;
+    }
+
+    PQHeap pq;
     DataPoint cur;
-    while(stream >> cur){
-        if(cur.priority<largestVals[k-1].priority){
-            continue; //cur is smaller than smallest val in largestVals, so don't save it
+    while(pq.size() < k && stream >> cur){//first k values are taken as they are
+        pq.enqueue(cur);
+    }
+    if(pq.size() == k){
+        double smallestKept = pq.peek().priority;
+        while(stream >> cur){
+            if(cur.priority <= smallestKept){
+                continue; //cur is no larger than smallest val kept, so don't save it
+            }
+            pq.replaceFront(cur);//cur takes the place of the smallest val kept
+            smallestKept = pq.peek().priority;
         }
-        largestVals.add(cur);//adds element that is one of the largest k elements
-        sortVec(largestVals, cur);//sorts the vector putting cur in its sorted spot
-        largestVals.remove(largestVals.size()-1);//removes smallest element from the vector to keep it at size k
     }
 
+    largestVals = Vector<DataPoint>(pq.size());
+    if(!largestVals.isEmpty()){
+        pq.dequeueMany(largestVals.size(), &largestVals[0]);
+        std::reverse(largestVals.begin(), largestVals.end());//dequeue is in increasing order
+    }
     return largestVals;
 }
 
 
+/* Function synopsis:
+ * These versions of topK read from a mapped binary DataPoint file or from the fast text parser in
+ * datapointio.h instead of an istream. They keep the k largest in a PQHeap the same way, but a point
+ * arrives as a view of its name, and the name is copied into a DataPoint only if the point makes the
+ * cut. Most points of a long stream cost one comparison and no allocation.
+ */
+template <typename Reader>
+Vector<DataPoint> topKOfViews(Reader& reader, int k) {
+    Vector<DataPoint> largestVals;
+    if(k <= 0){
+        return largestVals;
+    }
+
+    PQHeap pq;
+    DataPointView cur;
+    while(pq.size() < k && reader.next(cur)){
+        pq.enqueue(cur.toDataPoint());
+    }
+    if(pq.size() == k){
+        double smallestKept = pq.peek().priority;
+        while(reader.next(cur)){
+            if(cur.priority <= smallestKept){
+                continue;
+            }
+            pq.replaceFront(cur.toDataPoint());
+            smallestKept = pq.peek().priority;
+        }
+    }
+
+    largestVals = Vector<DataPoint>(pq.size());
+    if(!largestVals.isEmpty()){
+        pq.dequeueMany(largestVals.size(), &largestVals[0]);
+        std::reverse(largestVals.begin(), largestVals.end());
+    }
+    return largestVals;
+}
+
+Vector<DataPoint> topK(MappedDataPointFile& file, int k) {
+    return topKOfViews(file, k);
+}
+
+Vector<DataPoint> topK(TextDataPointReader& reader, int k) {
+    return topKOfViews(reader, k);
+}
+
+/* Function synopsis:
+ * These versions of pqSort return every point of a mapped binary file, or of DataPoint text, in
+ * increasing order of priority, starting over from the first point however much the caller has
+ * already read. The points are read straight into the vector that pqSort then sorts, so each name is
+ * copied once, from the input into the vector. The file's header gives the count, so that vector is
+ * allocated once at the right size.
+ */
+Vector<DataPoint> pqSort(MappedDataPointFile& file) {
+    file.rewind();
+    Vector<DataPoint> v(file.size());
+    DataPointView cur;
+    for (int i = 0; i < v.size() && file.next(cur); i++) {
+        v[i] = cur.toDataPoint();
+    }
+    pqSort(v);
+    return v;
+}
+
+Vector<DataPoint> pqSort(TextDataPointReader& reader) {
+    reader.rewind();
+    Vector<DataPoint> v;
+    DataPointView cur;
+    while (reader.next(cur)) {
+        v.add(cur.toDataPoint());
+    }
+    pqSort(v);
+    return v;
+}
+
+/* A reader over the points at indexes [begin, end) of a vector, in the form topKOfViews takes. The
+ * views refer to the vector's names, so the vector must not change while it is read. */
+class VectorPointReader {
+public:
+    VectorPointReader(const Vector<DataPoint>& points, int begin, int end)
+        : _points(points), _next(begin), _end(end) {}
+
+    bool next(DataPointView& view) {
+        if (_next == _end) {
+            return false;
+        }
+        view.name = _points[_next].name;
+        view.priority = _points[_next].priority;
+        _next++;
+        return true;
+    }
+
+private:
+    const Vector<DataPoint>& _points;
+    int _next;
+    int _end;
+};
+
+/* Function synopsis:
+ * topKOfParts runs topKOfViews on each part in a thread of its own, the calling thread taking the
+ * first part, so every thread has its own bounded heap and nothing is shared until the end. The top
+ * k overall is among the top k of the parts, so the partial results are then put together in part
+ * order and the same selection is run on those at most k * parts points.
+ */
+template <typename Reader>
+Vector<DataPoint> topKOfParts(vector<Reader>& parts, int k) {
+    Vector<Vector<DataPoint>> partial(parts.size());
+    vector<thread> workers;
+    for (int i = 1; i < int(parts.size()); i++) {
+        workers.push_back(thread([&parts, &partial, i, k]() {
+            partial[i] = topKOfViews(parts[i], k);
+        }));
+    }
+    partial[0] = topKOfViews(parts[0], k);
+    for (thread& worker : workers) {
+        worker.join();
+    }
+
+    Vector<DataPoint> candidates;
+    for (const Vector<DataPoint>& fromPart : partial) {
+        for (const DataPoint& dp : fromPart) {
+            candidates.add(dp);
+        }
+    }
+    VectorPointReader reader(candidates, 0, candidates.size());
+    return topKOfViews(reader, k);
+}
+
+/* Function synopsis:
+ * These versions of topK split their input into numThreads runs of consecutive points and select the
+ * top k of each run in parallel before merging, see topKOfParts. They return the same priorities in
+ * the same order as topK over the same points. When priorities tie, the same points come out as long
+ * as the tie is not at the k-th place; at the cut, which of the tied points is kept is arbitrary here
+ * as it is in topK. If numThreads is less than one, they call error().
+ */
+Vector<DataPoint> topKParallel(const Vector<DataPoint>& points, int k, int numThreads) {
+    if (numThreads < 1) {
+        error("topKParallel needs at least one thread");
+    }
+    vector<VectorPointReader> parts;
+    for (int t = 0; t < numThreads; t++) {
+        parts.push_back(VectorPointReader(points, long(points.size()) * t / numThreads,
+                                          long(points.size()) * (t + 1) / numThreads));
+    }
+    return topKOfParts(parts, k);
+}
+
+Vector<DataPoint> topKParallel(const MappedDataPointFile& file, int k, int numThreads) {
+    if (numThreads < 1) {
+        error("topKParallel needs at least one thread");
+    }
+    vector<DataPointRecords> parts = file.split(numThreads);
+    return topKOfParts(parts, k);
+}
+
 
 /* * * * * * Test Cases Below This Point * * * * * */
 
@@ -129,6 +393,291 @@ void fillVector(Vector<DataPoint>& vec, int n) {
 }
 
 
+/* Helper function to fill vector with n random DataPoints whose names are long enough
+ * that every copy of a name is a heap allocation. */
+void fillVectorLongNames(Vector<DataPoint>& vec, int n) {
+    vec.clear();
+    for (int i = 0; i < n; i++) {
+        DataPoint pt = { "a name long enough to defeat the small string optimization #" + integerToString(i), randomReal(0, 100) };
+        vec.add(pt);
+    }
+}
+
+/* Helper function that makes long-named ArenaDataPoints from the points of v. It is called in a
+ * CountingScope, so the names are allocated from the counting resource. */
+Vector<ArenaDataPoint> toArenaPoints(const Vector<DataPoint>& v) {
+    Vector<ArenaDataPoint> points;
+    for (const DataPoint& dp : v) {
+        points.add(ArenaDataPoint(dp));
+    }
+    return points;
+}
+
+/* Helper functions that return the allocations made so far for a queue's elements: the arrays
+ * counting has handed out, plus, for the DataPoint queues, one for every element the queue copied
+ * in. Those are long names, which std::string allocates from the general heap where no resource
+ * sees them. The names of an ArenaPQHeap come from counting itself, so its copies are already in
+ * the resource's count. */
+long allocationsSoFar(const PQHeap& pq, const CountingResource& counting) {
+    return counting.numAllocations() + pq.getCopyCount();
+}
+
+long allocationsSoFar(const PQArray& pq, const CountingResource& counting) {
+    return counting.numAllocations() + pq.getCopyCount();
+}
+
+long allocationsSoFar(const ArenaPQHeap&, const CountingResource& counting) {
+    return counting.numAllocations();
+}
+
+/* Helper function that runs every element of v through pq by copying (enqueue of an lvalue) or by
+ * moving, moves them all back out, and returns the number of allocations made along the way. */
+template <typename PQ, typename Point>
+long allocationsForRoundTrip(PQ& pq, Vector<Point>& v, bool moveElements, const CountingResource& counting) {
+    long before = allocationsSoFar(pq, counting);
+    for (int i = 0; i < v.size(); i++) {
+        if (moveElements) {
+            pq.enqueue(std::move(v[i]));
+        } else {
+            pq.enqueue(v[i]);
+        }
+    }
+    for (int i = 0; !pq.isEmpty(); i++) {
+        v[i] = pq.dequeue();
+    }
+    return allocationsSoFar(pq, counting) - before;
+}
+
+/* Helper function that runs every element of v through pq using emplace, and returns
+ * the number of allocations made. */
+template <typename PQ, typename Point>
+long allocationsForEmplace(PQ& pq, Vector<Point>& v, const CountingResource& counting) {
+    long before = allocationsSoFar(pq, counting);
+    for (int i = 0; i < v.size(); i++) {
+        pq.emplace(std::move(v[i].name), v[i].priority);
+    }
+    for (int i = 0; !pq.isEmpty(); i++) {
+        v[i] = pq.dequeue();
+    }
+    return allocationsSoFar(pq, counting) - before;
+}
+
+STUDENT_TEST("Allocation counts: copying versus moving long-named DataPoints") {
+    // Each queue takes its array from a counting resource; long names copied in are counted by the
+    // queue itself. Copying enqueue is how every element went in before move-aware enqueue.
+    int n = 20000;
+    Vector<DataPoint> v;
+
+    fillVectorLongNames(v, n);
+    CountingResource heapCounting;
+    PQHeap heap(&heapCounting);
+    long heapCopied = allocationsForRoundTrip(heap, v, false, heapCounting);
+    long heapMoved = allocationsForRoundTrip(heap, v, true, heapCounting);
+    long heapEmplaced = allocationsForEmplace(heap, v, heapCounting);
+    cout << "    PQHeap      n=" << n << " copied: " << heapCopied << " moved: " << heapMoved
+         << " emplaced: " << heapEmplaced << " allocations" << endl;
+    EXPECT(heapMoved < heapCopied);
+    EXPECT(heapEmplaced <= heapMoved);
+
+    fillVectorLongNames(v, n / 10);
+    CountingResource arrayCounting;
+    PQArray array(&arrayCounting);
+    long arrayCopied = allocationsForRoundTrip(array, v, false, arrayCounting);
+    long arrayMoved = allocationsForRoundTrip(array, v, true, arrayCounting);
+    long arrayEmplaced = allocationsForEmplace(array, v, arrayCounting);
+    cout << "    PQArray     n=" << n / 10 << " copied: " << arrayCopied << " moved: " << arrayMoved
+         << " emplaced: " << arrayEmplaced << " allocations" << endl;
+    EXPECT(arrayMoved < arrayCopied);
+    EXPECT(arrayEmplaced <= arrayMoved);
+
+    for (int i = 1; i < v.size(); i++) {
+        EXPECT(v[i-1].priority <= v[i].priority);
+    }
+
+    // The same round trips for an ArenaPQHeap, whose names are pmr strings: with the counting
+    // resource as the default, every name it or the test allocates is counted.
+    CountingResource arenaCounting;
+    CountingScope scope(&arenaCounting);
+    fillVectorLongNames(v, n);
+    Vector<ArenaDataPoint> points = toArenaPoints(v);
+    ArenaPQHeap arenaHeap(&arenaCounting);
+    long arenaCopied = allocationsForRoundTrip(arenaHeap, points, false, arenaCounting);
+    long arenaMoved = allocationsForRoundTrip(arenaHeap, points, true, arenaCounting);
+    long arenaEmplaced = allocationsForEmplace(arenaHeap, points, arenaCounting);
+    cout << "    ArenaPQHeap n=" << n << " copied: " << arenaCopied << " moved: " << arenaMoved
+         << " emplaced: " << arenaEmplaced << " allocations" << endl;
+    EXPECT(arenaMoved < arenaCopied);
+    EXPECT(arenaMoved < n / 100);
+    EXPECT(arenaEmplaced <= arenaCopied);  // emplace builds each name from a view, one allocation
+}
+
+/* Helper function that keeps pq at a steady size by replacing its front with the next element
+ * of v, over and over, and returns the number of allocations counted by counting. */
+template <typename PQ>
+long steadyStateAllocations(PQ& pq, const Vector<DataPoint>& v, int rounds, const CountingResource& counting) {
+    long before = counting.numAllocations();
+    for (int i = 0; i < rounds; i++) {
+        pq.dequeue();
+        const DataPoint& next = v[i % v.size()];
+        pq.emplace(next.name, next.priority);
+    }
+    return counting.numAllocations() - before;
+}
+
+STUDENT_TEST("Allocation counts: steady-state enqueue with and without a pool") {
+    int n = 10000;
+    Vector<DataPoint> v;
+    fillVectorLongNames(v, n);
+
+    CountingResource direct;
+    CountingResource underPool;
+    std::pmr::unsynchronized_pool_resource pool(&underPool);
+    ArenaPQHeap heap(&direct, n);
+    ArenaPQHeap pooledHeap(&pool, n);
+    for (int i = 0; i < n; i++) {
+        heap.emplace(v[i].name, v[i].priority);
+        pooledHeap.emplace(v[i].name, v[i].priority);
+    }
+    fillVectorLongNames(v, n);
+    long heapAllocations = steadyStateAllocations(heap, v, 5 * n, direct);
+    long pooledAllocations = steadyStateAllocations(pooledHeap, v, 5 * n, underPool);
+    cout << "    " << 5 * n << " dequeue/enqueue pairs, ArenaPQHeap on the general heap: " << heapAllocations
+         << " allocations, on a pool: " << pooledAllocations << endl;
+    EXPECT(heapAllocations >= 5 * n);
+    EXPECT(pooledAllocations < n / 100);
+}
+
+/* Helper function that returns the bytes a copy of name allocates from the general heap: nothing
+ * for a name that fits in the string's own small buffer, else its characters and terminator. */
+static long copiedNameBytes(const string& name) {
+    static const size_t inlineCapacity = string().capacity();
+    return name.size() > inlineCapacity ? long(name.size()) + 1 : 0;
+}
+
+/* Helper function that reports the bytes per element of a PQHeap and of an InternedPQHeap holding
+ * the same n elements, whose names are drawn from numNames distinct long names. The heap arrays are
+ * reserved up front so that the counts are not thrown off by the growth slack. The arrays are
+ * counted by a CountingResource; names are std::strings, which do not allocate through it, so the
+ * PQHeap's copies of them are added up from their lengths and the table's come from its estimate. */
+void reportBytesPerElement(int n, int numNames) {
+    Vector<string> hosts;
+    for (int i = 0; i < numNames; i++) {
+        hosts.add("worker-" + integerToString(i) + ".batch-cluster.example.com");
+    }
+
+    CountingResource heapCounting;
+    long heapBytes = 0;
+    {
+        CountingScope scope(&heapCounting);
+        PQHeap heap(n);
+        for (int i = 0; i < n; i++) {
+            heap.emplace(hosts[i % numNames], randomReal(0, 100));
+            heapBytes += copiedNameBytes(hosts[i % numNames]);
+        }
+    }
+    heapBytes += heapCounting.bytesAllocated();
+
+    CountingResource internedCounting;
+    NameTable names;
+    {
+        CountingScope scope(&internedCounting);
+        InternedPQHeap interned(names, n);
+        for (int i = 0; i < n; i++) {
+            interned.emplace(hosts[i % numNames], randomReal(0, 100));
+        }
+    }
+    long internedBytes = internedCounting.bytesAllocated() + names.bytesUsed();
+
+    cout << "    n=" << n << ", " << numNames << " distinct names: PQHeap "
+         << double(heapBytes) / n << " bytes/element, InternedPQHeap "
+         << double(internedBytes) / n << " bytes/element (table estimate "
+         << names.bytesUsed() << " bytes)" << endl;
+}
+
+STUDENT_TEST("Memory per element, PQHeap versus InternedPQHeap with repeated names") {
+    // Element sizes alone; the reports below include names and array slack.
+    cout << "    sizeof(DataPoint) = " << sizeof(DataPoint) << ", sizeof(InternedPoint) = "
+         << sizeof(InternedPoint) << endl;
+    for (int numNames = 10; numNames <= 10000; numNames *= 10) {
+        reportBytesPerElement(100000, numNames);
+    }
+}
+
+/* Helper function that destroys a heap, for timing teardown on its own. */
+template <typename PQ>
+void destroyHeap(unique_ptr<PQ>& pq) {
+    pq.reset();
+}
+
+STUDENT_TEST("ArenaPQHeap time trial, teardown of a full heap") {
+    for (int n = 250000; n <= 1000000; n *= 2) {
+        Vector<DataPoint> v;
+        fillVectorLongNames(v, n);
+        auto heap = make_unique<PQHeap>(n);
+        std::pmr::monotonic_buffer_resource arena;
+        auto arenaHeap = make_unique<ArenaPQHeap>(&arena, n, true);
+        for (int i = 0; i < n; i++) {
+            heap->emplace(v[i].name, v[i].priority);
+            arenaHeap->emplace(v[i].name, v[i].priority);
+        }
+        cout << "    PQHeap, n=" << n << endl;
+        TIME_OPERATION(n, destroyHeap(heap));
+        cout << "    ArenaPQHeap on a monotonic arena, teardown skipped, n=" << n << endl;
+        TIME_OPERATION(n, destroyHeap(arenaHeap));
+    }
+}
+
+STUDENT_TEST("pqSortInPlace: matches sorted order, small and random vectors") {
+    for (int n = 0; n <= 500; n = n * 2 + 1) {
+        Vector<DataPoint> input;
+        fillVector(input, n);
+        Vector<double> expected;
+        for (DataPoint dp : input) {
+            expected.add(dp.priority);
+        }
+        expected.sort();
+
+        pqSortInPlace(input);
+        EXPECT_EQUAL(input.size(), n);
+        for (int i = 0; i < input.size(); i++) {
+            EXPECT_EQUAL(input[i].priority, expected[i]);
+        }
+    }
+}
+
+/* Helper function to sort with the standard library, for comparison. */
+void stdSort(Vector<DataPoint>& v) {
+    sort(v.begin(), v.end(), [](const DataPoint& a, const DataPoint& b) {
+        return a.priority < b.priority;
+    });
+}
+
+/* Helper function that times one sorting function on a copy of input and reports the most memory
+ * its priority queues had in use. The counting resource is the default while it runs, so the arrays
+ * of the heaps it builds are counted. Anything allocated with new or a std::allocator, such as a
+ * temporary std::vector, is not; the trial compares queue memory, it does not prove a sort
+ * allocates nothing. */
+void timeSortAndMemory(string label, void (*sortFn)(Vector<DataPoint>&), const Vector<DataPoint>& input) {
+    Vector<DataPoint> v = input;
+    CountingResource counting;
+    {
+        CountingScope scope(&counting);
+        TIME_OPERATION(v.size(), sortFn(v));
+    }
+    cout << "    " << label << " queue arrays peaked at " << counting.peakBytesInUse() / 1024 << " KiB" << endl;
+}
+
+STUDENT_TEST("pqSort time/memory trial, copying pqSort vs in-place vs std::sort") {
+    for (int n = 250000; n <= 2000000; n *= 2) {
+        Vector<DataPoint> input;
+        fillVector(input, n);
+        cout << "    input vector holds " << n * sizeof(DataPoint) / 1024 << " KiB" << endl;
+        timeSortAndMemory("pqSort", pqSort, input);
+        timeSortAndMemory("pqSortInPlace", pqSortInPlace, input);
+        timeSortAndMemory("std::sort", stdSort, input);
+    }
+}
+
 STUDENT_TEST("Sorting a vector using pq sort 1 of 5"){
     int size = 10000;
         Vector<DataPoint> v;
@@ -157,6 +706,307 @@ STUDENT_TEST("Sorting a vector using pq sort 4 of 5"){
         TIME_OPERATION(size, pqSort(v));
 }
 
+/* Helper functions for the engine time trials. holdModel is the classic "hold" benchmark of event
+ * simulations: each step dequeues the earliest event and enqueues it again a random time later, so the
+ * queue stays the same size and its priorities only ever increase, which the radix heap requires. */
+template <typename PQ>
+void fillEvents(PQ& pq, int n) {
+    for (int i = 0; i < n; i++) {
+        pq.enqueue({ "", randomReal(0, 100) });
+    }
+}
+
+template <typename PQ>
+void holdModel(PQ& pq, int steps) {
+    for (int i = 0; i < steps; i++) {
+        DataPoint event = pq.dequeue();
+        event.priority += randomReal(0, 100);
+        pq.enqueue(std::move(event));
+    }
+}
+
+template <typename PQ>
+void drainEvents(PQ& pq) {
+    while (!pq.isEmpty()) {
+        pq.dequeue();
+    }
+}
+
+template <typename PQ>
+void timeEngine(string label, int n) {
+    PQ pq;
+    cout << "    " << label << ", n=" << n << endl;
+    TIME_OPERATION(n, fillEvents(pq, n));
+    TIME_OPERATION(n, holdModel(pq, n));
+    TIME_OPERATION(n, drainEvents(pq));
+}
+
+STUDENT_TEST("Engine time trial, monotone hold workload on every queue") {
+    for (int n = 10000; n <= 1000000; n *= 10) {
+        if (n <= 10000) {
+            timeEngine<PQArray>("PQArray", n);  // O(n) enqueue, too slow for the larger sizes
+        }
+        timeEngine<PQHeap>("PQHeap", n);
+        timeEngine<SplitPQHeap>("SplitPQHeap", n);
+        timeEngine<PairingPQHeap>("PairingPQHeap", n);
+        timeEngine<RadixPQHeap>("RadixPQHeap", n);
+    }
+}
+
+/* Helper function for the bucket queue time trial: a scheduler with priority levels 1 through levels.
+ * The queue is filled with n jobs, then each step runs the most urgent job and queues a new one at a
+ * random level, so most new jobs land at or behind the front. */
+template <typename PQ>
+void scheduleJobs(PQ& pq, int n, int levels) {
+    for (int i = 0; i < n; i++) {
+        pq.enqueue({ "", double(randomInteger(1, levels)) });
+    }
+    for (int i = 0; i < n; i++) {
+        pq.dequeue();
+        pq.enqueue({ "", double(randomInteger(1, levels)) });
+    }
+    while (!pq.isEmpty()) {
+        pq.dequeue();
+    }
+}
+
+STUDENT_TEST("Engine time trial, small whole-number priorities, PQHeap vs BucketPQueue") {
+    for (int n = 10000; n <= 1000000; n *= 10) {
+        for (int levels = 10; levels <= 1000; levels *= 10) {
+            cout << "    n=" << n << ", priorities 1 to " << levels << endl;
+            PQHeap heap;
+            BucketPQueue buckets(1, levels);
+            TIME_OPERATION(n, scheduleJobs(heap, n, levels));
+            TIME_OPERATION(n, scheduleJobs(buckets, n, levels));
+        }
+    }
+}
+
+STUDENT_TEST("Stable mode time trial, PQHeap vs StablePQHeap, distinct and tied priorities") {
+    for (int n = 10000; n <= 1000000; n *= 10) {
+        timeEngine<PQHeap>("PQHeap, distinct priorities", n);
+        timeEngine<StablePQHeap>("StablePQHeap, distinct priorities", n);
+        cout << "    n=" << n << ", priorities 1 to 10" << endl;
+        PQHeap heap;
+        StablePQHeap stable;
+        TIME_OPERATION(n, scheduleJobs(heap, n, 10));
+        TIME_OPERATION(n, scheduleJobs(stable, n, 10));
+    }
+}
+
+/* A PQHeap behind one mutex, the way a worker pool shares a queue that has no synchronization of its
+ * own. It is the baseline for the concurrent queues' throughput trials. */
+class LockedPQHeap {
+public:
+    LockedPQHeap(int capacity) : _heap(capacity) {}
+
+    void enqueue(DataPoint&& element) {
+        lock_guard<mutex> guard(_lock);
+        _heap.enqueue(std::move(element));
+    }
+
+    bool tryDequeue(DataPoint& front) {
+        lock_guard<mutex> guard(_lock);
+        if (_heap.isEmpty()) {
+            return false;
+        }
+        front = _heap.dequeue();
+        return true;
+    }
+
+private:
+    mutex _lock;
+    PQHeap _heap;
+};
+
+/* Helper function for the throughput trials: numThreads threads share opsPerThread * numThreads
+ * operations on an already filled queue, each thread alternating between queuing a job at a random
+ * priority and taking the most urgent one. Every thread draws from its own random generator, since the
+ * library's random functions share one. */
+template <typename PQ>
+void mixedWorkload(PQ& pq, int numThreads, int opsPerThread) {
+    vector<thread> workers;
+    for (int t = 0; t < numThreads; t++) {
+        workers.push_back(thread([&pq, t, opsPerThread]() {
+            minstd_rand generator(t + 1);
+            uniform_real_distribution<double> priority(0, 100);
+            DataPoint front;
+            for (int i = 0; i < opsPerThread; i += 2) {
+                pq.enqueue({ "", priority(generator) });
+                pq.tryDequeue(front);
+            }
+        }));
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+STUDENT_TEST("Throughput trial, mixed producers and consumers, LockedPQHeap vs ConcurrentPQHeap") {
+    int n = 100000;
+    int totalOps = 2000000;
+    int maxThreads = max(8, int(thread::hardware_concurrency()));
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        cout << "    " << threads << " threads, " << totalOps << " operations on a queue of " << n << endl;
+        LockedPQHeap locked(2 * n);
+        ConcurrentPQHeap concurrent(2 * n);
+        fillEvents(locked, n);
+        fillEvents(concurrent, n);
+        TIME_OPERATION(totalOps, mixedWorkload(locked, threads, totalOps / threads));
+        TIME_OPERATION(totalOps, mixedWorkload(concurrent, threads, totalOps / threads));
+    }
+}
+
+/* Helper function for the buffered heap trial: numProducers threads each queue perProducer jobs as fast
+ * as they can while the calling thread, the only consumer, takes jobs out until it has all of them. */
+template <typename PQ>
+void producersAndConsumer(PQ& pq, int numProducers, int perProducer) {
+    vector<thread> producers;
+    for (int t = 0; t < numProducers; t++) {
+        producers.push_back(thread([&pq, t, perProducer]() {
+            minstd_rand generator(t + 1);
+            uniform_real_distribution<double> priority(0, 100);
+            for (int i = 0; i < perProducer; i++) {
+                pq.enqueue({ "", priority(generator) });
+            }
+        }));
+    }
+    DataPoint front;
+    for (int taken = 0; taken < numProducers * perProducer; ) {
+        if (pq.tryDequeue(front)) {
+            taken++;
+        }
+    }
+    for (thread& producer : producers) {
+        producer.join();
+    }
+}
+
+STUDENT_TEST("Throughput trial, producers and one consumer, LockedPQHeap vs BufferedPQHeap") {
+    int total = 2000000;
+    int maxProducers = max(8, int(thread::hardware_concurrency()));
+    for (int producers = 1; producers <= maxProducers; producers *= 2) {
+        cout << "    " << producers << " producers, " << total << " jobs" << endl;
+        LockedPQHeap locked(total);
+        BufferedPQHeap buffered(total);
+        TIME_OPERATION(total, producersAndConsumer(locked, producers, total / producers));
+        TIME_OPERATION(total, producersAndConsumer(buffered, producers, total / producers));
+    }
+    cout << "    one thread, " << total << " jobs queued before the first dequeue" << endl;
+    PQHeap heap(total);
+    BufferedPQHeap buffered(total);
+    TIME_OPERATION(total, fillEvents(heap, total));
+    TIME_OPERATION(total, drainEvents(heap));
+    TIME_OPERATION(total, fillEvents(buffered, total));
+    TIME_OPERATION(total, drainEvents(buffered));
+}
+
+/* Helper function for the multi-queue quality trial. The queue is filled with n jobs of whole-number
+ * priorities below MAX_RANK_PRIORITY and then run for n steps, each queuing a new job and taking one out.
+ * The rank error of a dequeue is how many queued jobs were strictly more urgent than the one returned;
+ * a Fenwick tree over the priorities counts them in O(log) time. The errors are printed as a histogram
+ * with buckets 0, 1, 2-3, 4-7 and so on. */
+static const int MAX_RANK_PRIORITY = 1 << 20;
+
+void countPriority(Vector<int>& fenwick, int priority, int delta) {
+    for (int i = priority + 1; i <= MAX_RANK_PRIORITY; i += i & -i) {
+        fenwick[i] += delta;
+    }
+}
+
+int countBelow(const Vector<int>& fenwick, int priority) {
+    int count = 0;
+    for (int i = priority; i > 0; i -= i & -i) {
+        count += fenwick[i];
+    }
+    return count;
+}
+
+void reportRankErrors(MultiQueue& pq, int n) {
+    Vector<int> fenwick(MAX_RANK_PRIORITY + 1, 0);
+    Vector<long> histogram(32, 0);
+    long totalRank = 0;
+    int maxRank = 0;
+    for (int i = 0; i < 2 * n; i++) {
+        int priority = randomInteger(0, MAX_RANK_PRIORITY - 1);
+        pq.enqueue({ "", double(priority) });
+        countPriority(fenwick, priority, 1);
+        if (i >= n) {
+            int dequeued = int(pq.dequeue().priority);
+            int rank = countBelow(fenwick, dequeued);
+            countPriority(fenwick, dequeued, -1);
+            int bucket = 0;
+            while ((1 << bucket) <= rank) {
+                bucket++;
+            }
+            histogram[bucket]++;
+            totalRank += rank;
+            maxRank = max(maxRank, rank);
+        }
+    }
+    cout << "    " << pq.numQueues() << " sub-queues: mean rank error " << double(totalRank) / n
+         << ", max " << maxRank << endl;
+    for (int bucket = 0; (1 << bucket) / 2 <= maxRank; bucket++) {
+        int low = (1 << bucket) / 2;
+        int high = (1 << bucket) - 1;
+        cout << "      rank " << (low == high ? integerToString(low) : integerToString(low) + "-" + integerToString(high))
+             << ": " << histogram[bucket] << endl;
+    }
+}
+
+STUDENT_TEST("Quality trial, MultiQueue rank error histogram by number of sub-queues") {
+    for (int threads = 1; threads <= 16; threads *= 2) {
+        MultiQueue pq(threads);
+        reportRankErrors(pq, 100000);
+    }
+}
+
+STUDENT_TEST("Throughput trial, mixed producers and consumers, LockedPQHeap vs MultiQueue") {
+    int n = 100000;
+    int totalOps = 2000000;
+    int maxThreads = max(8, int(thread::hardware_concurrency()));
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        cout << "    " << threads << " threads, " << totalOps << " operations on a queue of " << n << endl;
+        LockedPQHeap locked(2 * n);
+        MultiQueue relaxed(threads);
+        fillEvents(locked, n);
+        fillEvents(relaxed, n);
+        TIME_OPERATION(totalOps, mixedWorkload(locked, threads, totalOps / threads));
+        TIME_OPERATION(totalOps, mixedWorkload(relaxed, threads, totalOps / threads));
+    }
+}
+
+/* Helper function for the decrease-key time trial: n elements are enqueued, then the queue is drained
+ * with decreasesPerDequeue priority decreases on random queued elements before every dequeue, the
+ * pattern of Dijkstra's algorithm on a graph with that many edges per vertex. */
+template <typename PQ>
+void decreaseKeyWorkload(int n, int decreasesPerDequeue) {
+    PQ pq(n);
+    Vector<int> handles;
+    for (int i = 0; i < n; i++) {
+        handles.add(pq.emplace("", randomReal(1000, 2000)));
+    }
+    while (!pq.isEmpty()) {
+        for (int i = 0; i < decreasesPerDequeue; i++) {
+            int handle = handles[randomInteger(0, n - 1)];
+            if (pq.contains(handle)) {
+                pq.changePriority(handle, pq.get(handle).priority * 0.99);
+            }
+        }
+        pq.dequeue();
+    }
+}
+
+STUDENT_TEST("Engine time trial, decrease-key heavy workload, AddressablePQHeap vs PairingPQHeap") {
+    for (int n = 100000; n <= 1000000; n *= 10) {
+        for (int decreases = 1; decreases <= 16; decreases *= 4) {
+            cout << "    n=" << n << ", " << decreases << " decreases per dequeue" << endl;
+            TIME_OPERATION(n, decreaseKeyWorkload<AddressablePQHeap>(n, decreases));
+            TIME_OPERATION(n, decreaseKeyWorkload<PairingPQHeap>(n, decreases));
+        }
+    }
+}
+
 STUDENT_TEST("topK: time trial with changing n") {
     int startSize = 200000;
     int k = 10;
@@ -179,6 +1029,244 @@ STUDENT_TEST("topK: time trial with changing k") {
     }
 }
 
+STUDENT_TEST("topK: time trial with k up to n/2") {
+    int sizeN = 200000;
+    for (int k = 10; k <= sizeN/2; k *= 10) {
+        Vector<DataPoint> input;
+        fillVector(input, sizeN);
+        stringstream stream = asStream(input);
+        TIME_OPERATION(k, topK(stream, k));
+    }
+}
+
+STUDENT_TEST("topK: large k matches sorted order") {
+    Vector<double> expected;
+    Vector<DataPoint> points;
+    fillVector(points, 20000);
+    for (DataPoint dp : points) {
+        expected.add(dp.priority);
+    }
+    sort(expected.begin(), expected.end(), greater<double>());
+
+    stringstream stream = asStream(points);
+    int k = 10000;
+    Vector<DataPoint> result = topK(stream, k);
+    EXPECT_EQUAL(result.size(), k);
+    for (int i = 0; i < k; i++) {
+        EXPECT_EQUAL(result[i].priority, expected[i]);
+    }
+}
+
+STUDENT_TEST("topK: a k far larger than the stream allocates only for the stream") {
+    Vector<DataPoint> points;
+    fillVector(points, 10);
+    Vector<DataPoint> sorted = points;
+    stdSort(sorted);
+    std::reverse(sorted.begin(), sorted.end());
+
+    stringstream stream = asStream(points);
+    EXPECT_EQUAL(topK(stream, 1000000000), sorted);
+    EXPECT_EQUAL(topKParallel(points, 1000000000, 4), sorted);
+}
+
+STUDENT_TEST("topK and pqSort: mapped binary file and text parser match the stream versions") {
+    setRandomSeed(22);
+    Vector<DataPoint> input;
+    fillVector(input, 5000);
+    string path = (filesystem::temp_directory_path() / "pqclient-topk-test.bin").string();
+    writeDataPointFile(path, input);
+    MappedDataPointFile file(path);
+    for (int k : { 0, 1, 10, 5000, 6000 }) {
+        stringstream stream = asStream(input);
+        stringstream text = asStream(input);
+        TextDataPointReader reader(text);
+        Vector<DataPoint> expected = topK(stream, k);
+        file.rewind();
+        EXPECT_EQUAL(topK(file, k), expected);
+        EXPECT_EQUAL(topK(reader, k), expected);
+    }
+
+    Vector<DataPoint> sorted = input;
+    pqSort(sorted);
+    file.rewind();
+    Vector<DataPoint> fromFile = pqSort(file);
+    stringstream text = asStream(input);
+    TextDataPointReader reader(text);
+    Vector<DataPoint> fromText = pqSort(reader);
+    EXPECT_EQUAL(fromFile.size(), sorted.size());
+    EXPECT_EQUAL(fromText.size(), sorted.size());
+    for (int i = 0; i < sorted.size(); i++) {
+        EXPECT_EQUAL(fromFile[i].priority, sorted[i].priority);
+        EXPECT_EQUAL(fromText[i].priority, sorted[i].priority);
+    }
+
+    // Points already read by the caller are still sorted, and nothing is made up in their place.
+    DataPointView view;
+    for (int i = 0; i < 100; i++) {
+        file.next(view);
+    }
+    fromFile = pqSort(file);
+    reader.rewind();
+    for (int i = 0; i < 100; i++) {
+        reader.next(view);
+    }
+    fromText = pqSort(reader);
+    EXPECT_EQUAL(fromFile, fromText);
+    for (int i = 0; i < sorted.size(); i++) {
+        EXPECT_EQUAL(fromFile[i].priority, sorted[i].priority);
+    }
+    remove(path.c_str());
+}
+
+/* Helper functions for the parse trial. The count functions read every point of their input and
+ * queue none of them, so their time is the parsing part of the matching topK. */
+int countStream(istream& stream) {
+    DataPoint cur;
+    int count = 0;
+    while (stream >> cur) {
+        count++;
+    }
+    return count;
+}
+
+template <typename Reader>
+int countViews(Reader& reader) {
+    DataPointView cur;
+    int count = 0;
+    while (reader.next(cur)) {
+        count++;
+    }
+    return count;
+}
+
+int countText(istream& stream) {
+    TextDataPointReader reader(stream);
+    return countViews(reader);
+}
+
+int countFile(const string& path) {
+    MappedDataPointFile file(path);
+    return countViews(file);
+}
+
+Vector<DataPoint> topKText(istream& stream, int k) {
+    TextDataPointReader reader(stream);
+    return topK(reader, k);
+}
+
+Vector<DataPoint> topKFile(const string& path, int k) {
+    MappedDataPointFile file(path);
+    return topK(file, k);
+}
+
+STUDENT_TEST("topK time trial, parse time versus queue time for stream, text parser and mapped file") {
+    int k = 10;
+    string path = (filesystem::temp_directory_path() / "pqclient-topk-trial.bin").string();
+    for (int n = 200000; n <= 1600000; n *= 2) {
+        Vector<DataPoint> input;
+        fillVector(input, n);
+        string text = asStream(input).str();
+        writeDataPointFile(path, input);   // just written, so the trial reads it from the page cache
+        cout << "    n = " << n << ", k = " << k << ": parse only, then topK (the difference is queue time)" << endl;
+        stringstream parseStream(text), queueStream(text), parseText(text), queueText(text);
+        TIME_OPERATION(n, countStream(parseStream));
+        TIME_OPERATION(n, topK(queueStream, k));
+        TIME_OPERATION(n, countText(parseText));
+        TIME_OPERATION(n, topKText(queueText, k));
+        TIME_OPERATION(n, countFile(path));
+        TIME_OPERATION(n, topKFile(path, k));
+    }
+    remove(path.c_str());
+}
+
+STUDENT_TEST("topKParallel: same result as topK for any number of threads") {
+    setRandomSeed(23);
+    Vector<DataPoint> input;
+    fillVector(input, 10000);
+    string path = (filesystem::temp_directory_path() / "pqclient-topk-parallel.bin").string();
+    writeDataPointFile(path, input);
+    MappedDataPointFile file(path);
+    for (int k : { 0, 1, 7, 2500, 10000, 12000 }) {
+        stringstream stream = asStream(input);
+        Vector<DataPoint> expected = topK(stream, k);
+        for (int threads : { 1, 2, 3, 8 }) {
+            EXPECT_EQUAL(topKParallel(input, k, threads), expected);
+            EXPECT_EQUAL(topKParallel(file, k, threads), expected);
+        }
+    }
+
+    Vector<DataPoint> few = { { "a", 3 }, { "b", 1 }, { "c", 2 } };
+    Vector<DataPoint> expected = { { "a", 3 }, { "c", 2 } };
+    EXPECT_EQUAL(topKParallel(few, 2, 8), expected);  // more threads than points
+    EXPECT_EQUAL(topKParallel(Vector<DataPoint>(), 2, 4), Vector<DataPoint>());
+    EXPECT_ERROR(topKParallel(few, 2, 0));
+    remove(path.c_str());
+}
+
+STUDENT_TEST("topKParallel time trial, threads from 1 up, vector and mapped file") {
+    int n = 4000000;
+    int maxThreads = max(8, int(thread::hardware_concurrency()));
+    Vector<DataPoint> input;
+    fillVector(input, n);
+    string path = (filesystem::temp_directory_path() / "pqclient-topk-scaling.bin").string();
+    writeDataPointFile(path, input);
+    MappedDataPointFile file(path);
+    for (int k : { 10, 1000 }) {
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            cout << "    " << threads << " threads, k = " << k << endl;
+            TIME_OPERATION(n, topKParallel(input, k, threads));
+            TIME_OPERATION(n, topKParallel(file, k, threads));
+        }
+    }
+    remove(path.c_str());
+}
+
+STUDENT_TEST("pqSortParallel: same order as pqSort for any number of threads, no element lost") {
+    setRandomSeed(24);
+    auto byPriorityThenName = [](const DataPoint& a, const DataPoint& b) {
+        return a.priority < b.priority || (a.priority == b.priority && a.name < b.name);
+    };
+    for (int n : { 0, 1, 2, 7, 1000, 10001 }) {
+        Vector<DataPoint> input;
+        for (int i = 0; i < n; i++) {
+            input.add({ integerToString(i), double(randomInteger(0, n / 2)) });  // with ties
+        }
+        Vector<DataPoint> expected = input;
+        sort(expected.begin(), expected.end(), byPriorityThenName);
+        for (int threads : { 1, 2, 3, 8, 16 }) {
+            Vector<DataPoint> v = input;
+            pqSortParallel(v, threads);
+            EXPECT_EQUAL(v.size(), n);
+            for (int i = 1; i < v.size(); i++) {
+                EXPECT(v[i-1].priority <= v[i].priority);
+            }
+            sort(v.begin(), v.end(), byPriorityThenName);  // reorders ties only
+            EXPECT_EQUAL(v, expected);
+        }
+    }
+    Vector<DataPoint> v = { { "a", 1 } };
+    EXPECT_ERROR(pqSortParallel(v, 0));
+}
+
+/* Compares pqSort with pqSortParallel at each thread count. The vector is refilled with random points
+ * before every sort. The sweep stops at 10^7 DataPoints by default. Setting the environment variable
+ * PQSORT_TRIAL_1E8 adds a run with 10^8, which, with pqSort's copy or the merge buffer, needs about
+ * 8 GB of memory. */
+STUDENT_TEST("pqSortParallel time trial, against pqSort from 10^6 to 10^7 elements by threads") {
+    int maxThreads = max(8, int(thread::hardware_concurrency()));
+    int maxN = getenv("PQSORT_TRIAL_1E8") != nullptr ? 100000000 : 10000000;
+    for (int n = 1000000; n <= maxN; n *= 10) {
+        Vector<DataPoint> v;
+        fillVector(v, n);
+        cout << "    n = " << n << ": pqSort, then pqSortParallel with 1, 2, 4, ... threads" << endl;
+        TIME_OPERATION(n, pqSort(v));
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            fillVector(v, n);
+            TIME_OPERATION(n, pqSortParallel(v, threads));
+        }
+    }
+}
+
 PROVIDED_TEST("pqSort: vector of random elements") {
     setRandomSeed(137); //good idea to set seed here so that any "randomized" values in the entire test case follow this seed
 
@@ -0,0 +1,134 @@
+/*
+ * File Synopsis:
+ * The concurrent heap is a binary heap that many threads can enqueue to and dequeue from at once, with a
+ * lock on every slot instead of one lock around the whole queue. It is a class template, so its
+ * implementation lives in pqconcurrent.h. This file instantiates the DataPoint queue (ConcurrentPQHeap)
+ * and contains its tests; the throughput trial against a PQHeap behind one mutex is in pqclient.cpp.
+ */
+
+#include "pqconcurrent.h"
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include "datapoint.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/* The DataPoint queue is instantiated here so that every member function is compiled
+ * even if no test happens to call it.
+ */
+template class BasicConcurrentPQHeap<DataPoint, std::less<>, DataPointPriority>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("bitReversedSlot: each level is filled exactly, in alternating halves") {
+    EXPECT_EQUAL(bitReversedSlot(1), 1);
+    Vector<int> level = { bitReversedSlot(8), bitReversedSlot(9), bitReversedSlot(10), bitReversedSlot(11) };
+    Vector<int> expected = { 8, 12, 10, 14 };
+    EXPECT_EQUAL(level, expected);
+    for (int leading = 1; leading <= 1024; leading *= 2) {
+        Vector<int> timesSeen(2 * leading, 0);
+        for (int n = leading; n < 2 * leading; n++) {
+            int slot = bitReversedSlot(n);
+            EXPECT(slot >= leading && slot < 2 * leading);
+            timesSeen[slot]++;
+        }
+        for (int slot = leading; slot < 2 * leading; slot++) {
+            EXPECT_EQUAL(timesSeen[slot], 1);
+        }
+    }
+}
+
+STUDENT_TEST("ConcurrentPQHeap: example from writeup, validate each step") {
+    ConcurrentPQHeap pq(9);
+    Vector<DataPoint> input = {
+        { "R", 4 }, { "A", 5 }, { "B", 3 }, { "K", 7 }, { "G", 2 },
+        { "V", 9 }, { "T", 1 }, { "O", 8 }, { "S", 6 } };
+
+    pq.validateInternalState();
+    for (DataPoint dp : input) {
+        pq.enqueue(dp);
+        pq.validateInternalState();
+    }
+    EXPECT_ERROR(pq.enqueue({ "full", 0 }));
+    DataPoint expectedFront = { "T", 1 };
+    EXPECT_EQUAL(pq.peek(), expectedFront);
+    for (int expected = 1; expected <= 9; expected++) {
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+        pq.validateInternalState();
+    }
+    DataPoint unused;
+    EXPECT(!pq.tryDequeue(unused));
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peek());
+    EXPECT_ERROR(ConcurrentPQHeap(0));
+}
+
+STUDENT_TEST("ConcurrentPQHeap: concurrent producers, then drain in order") {
+    const int numThreads = 4;
+    const int perThread = 5000;
+    ConcurrentPQHeap pq(numThreads * perThread);
+    vector<thread> producers;
+    for (int t = 0; t < numThreads; t++) {
+        producers.push_back(thread([&pq, t]() {
+            for (int i = 0; i < perThread; i++) {
+                pq.emplace(integerToString(t), double(i * numThreads + t));
+            }
+        }));
+    }
+    for (thread& producer : producers) {
+        producer.join();
+    }
+    EXPECT_EQUAL(pq.size(), numThreads * perThread);
+    pq.validateInternalState();
+    for (int expected = 0; expected < numThreads * perThread; expected++) {
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+    }
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("ConcurrentPQHeap: mixed producers and consumers lose and duplicate nothing") {
+    const int numThreads = 4;
+    const int perThread = 5000;
+    ConcurrentPQHeap pq(numThreads * perThread);
+    Vector<Vector<double>> taken(numThreads);
+    vector<thread> workers;
+    for (int t = 0; t < numThreads; t++) {
+        workers.push_back(thread([&pq, &taken, t]() {
+            DataPoint front;
+            for (int i = 0; i < perThread; i++) {
+                pq.emplace("", double(i * numThreads + t));
+                if (i % 2 == 1 && pq.tryDequeue(front)) {
+                    taken[t].add(front.priority);
+                }
+            }
+        }));
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    pq.validateInternalState();
+
+    Vector<double> all;
+    for (const Vector<double>& fromThread : taken) {
+        for (double priority : fromThread) {
+            all.add(priority);
+        }
+    }
+    double previous = -1;
+    while (!pq.isEmpty()) {
+        DataPoint front = pq.dequeue();
+        EXPECT(front.priority >= previous);
+        previous = front.priority;
+        all.add(front.priority);
+    }
+    sort(all.begin(), all.end());
+    EXPECT_EQUAL(all.size(), numThreads * perThread);
+    for (int i = 0; i < all.size(); i++) {
+        EXPECT_EQUAL(all[i], i);
+    }
+}
@@ -0,0 +1,443 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "strlib.h"
+#include "pqheap.h"
+
+/**
+ * Returns the heap slot that holds the n-th element of a concurrent heap
+ * (n >= 1, slots numbered from 1 at the root). Slot n and the result are on
+ * the same level, with the bits below the leading one reversed, so elements
+ * n and n+1 land in different halves of the tree. Concurrent enqueues, which
+ * sift up from consecutive slots, then share few ancestors and rarely wait on
+ * each other's locks. Within a level this is a permutation, so the first n
+ * elements always fill exactly the slots bitReversedSlot(1) .. bitReversedSlot(n).
+ */
+inline int bitReversedSlot(int n) {
+    int leading = 1;
+    while (leading <= n / 2) {
+        leading *= 2;
+    }
+    int slot = leading;
+    for (int bit = 1, mirror = leading / 2; mirror > 0; bit *= 2, mirror /= 2) {
+        if (n & bit) {
+            slot |= mirror;
+        }
+    }
+    return slot;
+}
+
+/**
+ * Priority queue of elements of type T that any number of threads may
+ * enqueue to and dequeue from at the same time, without an outside lock.
+ *
+ * It is the concurrent heap of Hunt, Michael, Parthasarathy and Scott: a
+ * binary heap in a fixed array where every slot has its own mutex and a tag.
+ * A mutex for the whole heap is held only long enough to claim a slot, so it
+ * is never held during a sift.
+ * - enqueue claims the next free slot, writes its element there and sifts it
+ *   up, locking a parent and child pair at a time. Its element is tagged with
+ *   a ticket of its own until it stops, so if a dequeue moves the element
+ *   meanwhile, the enqueue follows it up the tree.
+ * - dequeue takes the element out of the last filled slot, puts it at the
+ *   root in place of the front and sifts it down hand over hand.
+ * Locks are always taken top-down, parent before child and left before right,
+ * so operations on different parts of the heap proceed in parallel and never
+ * deadlock.
+ *
+ * Unlike BasicPQHeap, the capacity is fixed when the queue is created, since
+ * replacing the array would need every slot lock at once; enqueuing into a
+ * full queue calls error().
+ *
+ * KeyFn and Compare mean the same as for BasicPQHeap. peek returns a copy,
+ * since another thread may dequeue the front at any time, and tryDequeue is
+ * the form of dequeue for threads that cannot know the queue is nonempty.
+ */
+template <typename T, typename Compare = std::less<>, typename KeyFn = IdentityKey>
+class BasicConcurrentPQHeap {
+public:
+    /**
+     * Creates a new, empty priority queue with room for capacity elements.
+     * If capacity is less than one or more than 2^29, this function calls
+     * error().
+     *
+     * @param capacity The most elements the queue can hold at once.
+     */
+    BasicConcurrentPQHeap(int capacity);
+
+    /**
+     * Cleans up all memory allocated by this priority queue.
+     */
+    ~BasicConcurrentPQHeap();
+
+    /**
+     * Adds a new element into the queue. This operation runs in time O(log n)
+     * plus the time spent waiting for other threads' locks.
+     *
+     * If the queue is full, this function calls error().
+     *
+     * @param element The element to add.
+     */
+    void enqueue(const T& element);
+    void enqueue(T&& element);
+
+    /**
+     * Adds a new element into the queue, constructing it from the given
+     * arguments.
+     *
+     * @param args The arguments used to brace-initialize the element.
+     */
+    template <typename... Args>
+    void emplace(Args&&... args);
+
+    /**
+     * Removes and returns the element that is frontmost in this priority
+     * queue. Elements of equal priority come out in arbitrary order.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(log n) plus the time spent waiting.
+     *
+     * @return The frontmost element, which is removed from queue.
+     */
+    T dequeue();
+
+    /**
+     * Removes the frontmost element and moves it into front, or returns false
+     * and leaves front alone if the queue is empty. The check and the removal
+     * are one step, which dequeue after isEmpty is not when other threads are
+     * dequeuing too.
+     *
+     * @param front Receives the frontmost element.
+     * @return Whether an element was dequeued.
+     */
+    bool tryDequeue(T& front);
+
+    /**
+     * Returns a copy of the element that is frontmost.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * @return frontmost element
+     */
+    T peek() const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Returns the most elements this priority queue can hold.
+     */
+    int capacity() const;
+
+    /**
+     * Removes all elements from the priority queue. No other thread may use
+     * the queue during a call to clear.
+     */
+    void clear();
+
+    /*
+     * This function exists purely for testing purposes. It prints the
+     * filled slots of the heap. No other thread may use the queue meanwhile.
+     */
+    void printDebugInfo(std::string msg) const;
+
+    /*
+     * This function exits purely for testing purposes. It verifies that
+     * exactly the first size() slots in bitReversedSlot order are filled,
+     * that no enqueue is still in progress and that the heap is in order.
+     * No other thread may use the queue meanwhile.
+     * If a problem is detected, this function calls error().
+     */
+    void validateInternalState() const;
+
+private:
+    static constexpr uint64_t EMPTY = 0;     // tag of a slot without an element
+    static constexpr uint64_t AVAILABLE = 1; // tag of an element that is in place
+                                             // any other tag is the ticket of an enqueue still sifting it up
+
+    /* A slot of the heap. Each is aligned to a cache line so that threads
+     * working on neighboring slots do not contend for the same line. */
+    struct alignas(64) Slot {
+        std::mutex lock;
+        uint64_t tag = EMPTY;
+        T element{};
+    };
+
+    Slot* _slots;           // _slots[1] is the root, the children of slot i are 2i and 2i+1
+    int _numSlots;          // slots allocated, including unused _slots[0]
+    int _capacity;          // most elements held at once
+    mutable std::mutex _heapLock; // guards _numFilled and _nextTicket
+    int _numFilled;         // number of elements, or of slots claimed by enqueues
+    uint64_t _nextTicket;   // tag for the next enqueue
+
+    Compare _compare;       // orders two priorities, true if the first is more urgent
+    KeyFn _key;             // reads the priority of an element
+
+    bool isMoreUrgent(int slotA, int slotB) const;
+    void swapSlots(int slotA, int slotB);  // exchanges elements and tags
+
+    DISALLOW_COPYING_OF(BasicConcurrentPQHeap);
+};
+
+/*
+ * The allocator rounds the array up to a whole number of levels, since the
+ * slot of the last element may be anywhere in the bottom level.
+ */
+template <typename T, typename Compare, typename KeyFn>
+BasicConcurrentPQHeap<T, Compare, KeyFn>::BasicConcurrentPQHeap(int capacity) {
+    if (capacity < 1 || capacity > (1 << 29)) {
+        error("Concurrent heap capacity must be between 1 and " + integerToString(1 << 29));
+    }
+    _capacity = capacity;
+    _numSlots = 2;
+    while (_numSlots <= capacity) {
+        _numSlots *= 2;
+    }
+    _slots = new Slot[_numSlots];
+    _numFilled = 0;
+    _nextTicket = AVAILABLE + 1;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+BasicConcurrentPQHeap<T, Compare, KeyFn>::~BasicConcurrentPQHeap() {
+    delete[] _slots;
+}
+
+/*
+ * Private helper that compares the elements of two slots, whose locks the
+ * caller holds.
+ */
+template <typename T, typename Compare, typename KeyFn>
+bool BasicConcurrentPQHeap<T, Compare, KeyFn>::isMoreUrgent(int slotA, int slotB) const {
+    return _compare(_key(_slots[slotA].element), _key(_slots[slotB].element));
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicConcurrentPQHeap<T, Compare, KeyFn>::swapSlots(int slotA, int slotB) {
+    std::swap(_slots[slotA].element, _slots[slotB].element);
+    std::swap(_slots[slotA].tag, _slots[slotB].tag);
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicConcurrentPQHeap<T, Compare, KeyFn>::enqueue(const T& element) {
+    enqueue(T(element));
+}
+
+/*
+ * The new element is written to a freshly claimed slot under that slot's lock
+ * and tagged with this enqueue's ticket. Each step of the sift locks the
+ * parent and then the child, and looks at where the element went:
+ * - still in the child and more urgent than an available parent: swap, go up;
+ * - still in the child but not more urgent: mark it available and stop;
+ * - the parent is empty: a dequeue took the element to the root, so it is
+ *   already in a valid place and the dequeue made it available;
+ * - no longer in the child: a dequeue swapped it upwards, so follow it.
+ * If the parent is tagged by another enqueue, neither may move yet, so the
+ * step is retried after letting that enqueue's thread run.
+ */
+template <typename T, typename Compare, typename KeyFn>
+void BasicConcurrentPQHeap<T, Compare, KeyFn>::enqueue(T&& element) {
+    std::unique_lock<std::mutex> heapLock(_heapLock);
+    if (_numFilled == _capacity) {
+        heapLock.unlock();
+        error("Concurrent heap is full at " + integerToString(_capacity) + " elements");
+    }
+    uint64_t ticket = _nextTicket++;
+    int slot = bitReversedSlot(++_numFilled);
+    _slots[slot].lock.lock();
+    heapLock.unlock();
+    _slots[slot].element = std::move(element);
+    _slots[slot].tag = ticket;
+    _slots[slot].lock.unlock();
+
+    while (slot > 1) {
+        int parent = slot / 2;
+        std::lock_guard<std::mutex> parentLock(_slots[parent].lock);
+        std::lock_guard<std::mutex> childLock(_slots[slot].lock);
+        if (_slots[parent].tag == AVAILABLE && _slots[slot].tag == ticket) {
+            if (isMoreUrgent(slot, parent)) {
+                swapSlots(slot, parent);
+                slot = parent;
+            } else {
+                _slots[slot].tag = AVAILABLE;
+                return;
+            }
+        } else if (_slots[parent].tag == EMPTY) {
+            return;
+        } else if (_slots[slot].tag != ticket) {
+            slot = parent;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    std::lock_guard<std::mutex> rootLock(_slots[1].lock);
+    if (_slots[1].tag == ticket) {
+        _slots[1].tag = AVAILABLE;
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn>
+template <typename... Args>
+void BasicConcurrentPQHeap<T, Compare, KeyFn>::emplace(Args&&... args) {
+    enqueue(buildElement<T>(std::forward<Args>(args)...));
+}
+
+template <typename T, typename Compare, typename KeyFn>
+T BasicConcurrentPQHeap<T, Compare, KeyFn>::dequeue() {
+    T front;
+    if (!tryDequeue(front)) {
+        error("PQueue is empty!");
+    }
+    return front;
+}
+
+/*
+ * The last filled slot is emptied and its element takes the place of the
+ * front at the root. If the root was that last slot it is now empty and the
+ * element taken out is the front itself. Otherwise the element sifts down:
+ * with the parent locked, both children are locked, the less urgent one is
+ * released, and the parent's lock is released once the element has moved
+ * into the more urgent child or stopped.
+ */
+template <typename T, typename Compare, typename KeyFn>
+bool BasicConcurrentPQHeap<T, Compare, KeyFn>::tryDequeue(T& front) {
+    std::unique_lock<std::mutex> heapLock(_heapLock);
+    if (_numFilled == 0) {
+        return false;
+    }
+    int last = bitReversedSlot(_numFilled--);
+    _slots[last].lock.lock();
+    heapLock.unlock();
+    T moving = std::move(_slots[last].element);
+    _slots[last].tag = EMPTY;
+    _slots[last].lock.unlock();
+
+    _slots[1].lock.lock();
+    if (_slots[1].tag == EMPTY) {
+        _slots[1].lock.unlock();
+        front = std::move(moving);
+        return true;
+    }
+    front = std::move(_slots[1].element);
+    _slots[1].element = std::move(moving);
+    _slots[1].tag = AVAILABLE;
+
+    int slot = 1;
+    while (2 * slot < _numSlots) {
+        int left = 2 * slot;
+        int right = left + 1;
+        _slots[left].lock.lock();
+        _slots[right].lock.lock();
+        int child;
+        if (_slots[left].tag == EMPTY) {
+            _slots[right].lock.unlock();
+            _slots[left].lock.unlock();
+            break;
+        } else if (_slots[right].tag == EMPTY || !isMoreUrgent(right, left)) {
+            _slots[right].lock.unlock();
+            child = left;
+        } else {
+            _slots[left].lock.unlock();
+            child = right;
+        }
+        if (!isMoreUrgent(child, slot)) {
+            _slots[child].lock.unlock();
+            break;
+        }
+        swapSlots(child, slot);
+        _slots[slot].lock.unlock();
+        slot = child;
+    }
+    _slots[slot].lock.unlock();
+    return true;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+T BasicConcurrentPQHeap<T, Compare, KeyFn>::peek() const {
+    std::lock_guard<std::mutex> rootLock(_slots[1].lock);
+    if (_slots[1].tag == EMPTY) {
+        error("PQueue is empty!");
+    }
+    return _slots[1].element;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+bool BasicConcurrentPQHeap<T, Compare, KeyFn>::isEmpty() const {
+    return size() == 0;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+int BasicConcurrentPQHeap<T, Compare, KeyFn>::size() const {
+    std::lock_guard<std::mutex> heapLock(_heapLock);
+    return _numFilled;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+int BasicConcurrentPQHeap<T, Compare, KeyFn>::capacity() const {
+    return _capacity;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicConcurrentPQHeap<T, Compare, KeyFn>::clear() {
+    std::lock_guard<std::mutex> heapLock(_heapLock);
+    for (int n = 1; n <= _numFilled; n++) {
+        _slots[bitReversedSlot(n)].tag = EMPTY;
+    }
+    _numFilled = 0;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicConcurrentPQHeap<T, Compare, KeyFn>::printDebugInfo(std::string msg) const {
+    std::cout << msg << std::endl;
+    for (int slot = 1; slot < _numSlots; slot++) {
+        if (_slots[slot].tag != EMPTY) {
+            std::cout << "[" << slot << "] = " << _slots[slot].element << std::endl;
+        }
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicConcurrentPQHeap<T, Compare, KeyFn>::validateInternalState() const {
+    if (_numFilled > _capacity) error("Too many elements in not enough space!");
+    int filled = 0;
+    for (int slot = 1; slot < _numSlots; slot++) {
+        if (_slots[slot].tag == EMPTY) {
+            continue;
+        }
+        filled++;
+        if (_slots[slot].tag != AVAILABLE) {
+            error("Slot " + integerToString(slot) + " is still tagged by an enqueue.");
+        }
+        if (slot > 1 && (_slots[slot / 2].tag == EMPTY || isMoreUrgent(slot, slot / 2))) {
+            error("Slot " + integerToString(slot) + " has an incorrect priority relationship to its parent.");
+        }
+    }
+    if (filled != _numFilled) error("The number of filled slots does not match the size.");
+    for (int n = 1; n <= _numFilled; n++) {
+        if (_slots[bitReversedSlot(n)].tag == EMPTY) {
+            error("Slot " + integerToString(bitReversedSlot(n)) + " should be filled but is empty.");
+        }
+    }
+}
+
+/**
+ * Concurrent priority queue of DataPoints, smallest priority first.
+ */
+using ConcurrentPQHeap = BasicConcurrentPQHeap<DataPoint, std::less<>, DataPointPriority>;
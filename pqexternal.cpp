@@ -0,0 +1,394 @@
+/*
+ * File Synopsis:
+ * This file implements ExternalPQHeap, a priority queue that stays within a memory budget by spilling
+ * sorted runs of its elements to temporary files and merging them back as they reach the front. The
+ * in-memory part is a PQHeap, and the runs are written and mapped with the binary DataPoint format of
+ * datapointio.h. The tests, and a time trial with queues several times the budget, are at the bottom.
+ */
+
+#include "pqexternal.h"
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/*
+ * The constructor splits the budget in two: the heap's array is reserved at once to hold as many
+ * elements as half of the budget allows, and the rest is for names. Run files are named after a
+ * random tag and the queue's address, so that queues in this or another process never share a file.
+ */
+ExternalPQHeap::ExternalPQHeap(long memoryBudget, string directory) {
+    _maxInMemory = int(min(memoryBudget / 2 / long(sizeof(DataPoint)), long(INT32_MAX)));
+    if (_maxInMemory < 2) {
+        error("A memory budget of " + integerToString(int(memoryBudget)) + " bytes does not fit two elements");
+    }
+    _maxNameBytes = memoryBudget - long(_maxInMemory) * long(sizeof(DataPoint));
+    _nameBytes = 0;
+    _numOnDisk = 0;
+    _heap.reserve(_maxInMemory);
+    _directory = directory.empty() ? filesystem::temp_directory_path().string() : directory;
+    _filePrefix = "pqspill-" + to_string(random_device()()) + "-" + to_string(uintptr_t(this)) + "-";
+}
+
+ExternalPQHeap::~ExternalPQHeap() {
+    clear();
+}
+
+/*
+ * Function Synopsis:
+ * nameBytes returns the bytes a name needs outside the std::string, its characters and terminator, or
+ * 0 for a name short enough to be stored inside the string itself, which an empty string's capacity
+ * tells apart portably. It depends only on the name's length, not on the capacity of whatever buffer
+ * the string holds, so dequeue releases exactly what enqueue counted for the same element.
+ */
+long ExternalPQHeap::nameBytes(const DataPoint& element) {
+    static const size_t inlineCapacity = string().capacity();
+    return element.name.size() > inlineCapacity ? long(element.name.size()) + 1 : 0;
+}
+
+/*
+ * Function Synopsis:
+ * The enqueue functions spill the heap first if the new element would not fit in the budget, then add
+ * it to the heap. A spill empties the heap, so the element then always fits, except for a name longer
+ * than the whole name budget, which is let through on its own. No value is returned.
+ */
+void ExternalPQHeap::enqueue(const DataPoint& elem) {
+    enqueue(DataPoint(elem));
+}
+
+void ExternalPQHeap::enqueue(DataPoint&& elem) {
+    long bytes = nameBytes(elem);
+    if (_heap.size() == _maxInMemory || (!_heap.isEmpty() && _nameBytes + bytes > _maxNameBytes)) {
+        spill();
+    }
+    _nameBytes += bytes;
+    _heap.enqueue(std::move(elem));
+}
+
+void ExternalPQHeap::emplace(string name, double priority) {
+    enqueue(DataPoint{ std::move(name), priority });
+}
+
+/*
+ * Function Synopsis:
+ * spill sorts the heap's array in place, most urgent first, and writes it to a new run file, so the run
+ * comes out already sorted and no second array is needed. The file is then mapped and its first element
+ * becomes the run's head in the merge heap. The heap is cleared only once the run is safely on disk: if
+ * writing or mapping the file fails, the partial file is removed and the error passed on, and every
+ * element is still in the heap. Clearing alone would leave the spilled names' buffers in the array's
+ * slots, outside the name budget, so the array is released and a fresh one reserved. Nothing is
+ * returned.
+ */
+void ExternalPQHeap::spill() {
+    Run run;
+    run.path = (filesystem::path(_directory) / (_filePrefix + to_string(_runs.size()) + ".bin")).string();
+    int count = _heap.size();
+    const DataPoint* sorted = _heap.sortInPlace();
+    try {
+        DataPointFileWriter writer(run.path);
+        for (int i = 0; i < count; i++) {
+            writer.write(sorted[i]);
+        }
+        writer.close();
+        run.file = make_unique<MappedDataPointFile>(run.path);
+    } catch (...) {
+        run.file.reset();
+        remove(run.path.c_str());
+        throw;
+    }
+    _heap.clear();
+    _heap.shrinkToFit();
+    _heap.reserve(_maxInMemory);
+    _nameBytes = 0;
+
+    DataPointView view;
+    run.file->next(view);
+    run.head = view.toDataPoint();
+    _heads.enqueue({ run.head.priority, int(_runs.size()) });
+    _runs.push_back(std::move(run));
+    _numOnDisk += count;
+}
+
+void ExternalPQHeap::closeRun(Run& run) {
+    if (run.file != nullptr) {
+        run.file.reset();
+        remove(run.path.c_str());
+    }
+}
+
+bool ExternalPQHeap::headIsNext() const {
+    return !_heads.isEmpty() && (_heap.isEmpty() || _heads.peek().priority < _heap.peek().priority);
+}
+
+/*
+ * Function Synopsis:
+ * dequeue takes the front of the heap unless a run's head is more urgent. Taking a head reads the next
+ * element of the same run from its mapping and puts it in the head's place in the merge heap; a run
+ * with nothing left is closed and its file deleted, and once no run is left the list of runs starts
+ * over. The element taken is returned.
+ */
+DataPoint ExternalPQHeap::dequeue() {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    if (!headIsNext()) {
+        DataPoint front = _heap.dequeue();
+        _nameBytes -= nameBytes(front);
+        return front;
+    }
+    int index = _heads.peek().run;
+    Run& run = _runs[index];
+    DataPoint front = std::move(run.head);
+    DataPointView view;
+    if (run.file->next(view)) {
+        run.head = view.toDataPoint();
+        _heads.replaceFront({ run.head.priority, index });
+    } else {
+        _heads.dequeue();
+        closeRun(run);
+        if (_heads.isEmpty()) {
+            _runs.clear();
+        }
+    }
+    _numOnDisk--;
+    return front;
+}
+
+DataPoint ExternalPQHeap::peek() const {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    return headIsNext() ? _runs[_heads.peek().run].head : _heap.peek();
+}
+
+bool ExternalPQHeap::isEmpty() const {
+    return size() == 0;
+}
+
+int ExternalPQHeap::size() const {
+    return _heap.size() + _numOnDisk;
+}
+
+int ExternalPQHeap::sizeOnDisk() const {
+    return _numOnDisk;
+}
+
+int ExternalPQHeap::numRuns() const {
+    return _heads.size();
+}
+
+void ExternalPQHeap::clear() {
+    _heap.clear();
+    _nameBytes = 0;
+    for (Run& run : _runs) {
+        closeRun(run);
+    }
+    _runs.clear();
+    _heads.clear();
+    _numOnDisk = 0;
+}
+
+void ExternalPQHeap::printDebugInfo(string msg) const {
+    cout << msg << endl;
+    _heap.printDebugInfo("in memory");
+    for (int i = 0; i < int(_runs.size()); i++) {
+        if (_runs[i].file != nullptr) {
+            cout << "run " << i << " (" << _runs[i].path << ") head = " << _runs[i].head << endl;
+        }
+    }
+}
+
+void ExternalPQHeap::validateInternalState() const {
+    _heap.validateInternalState();
+    _heads.validateInternalState();
+    if (_heap.size() > _maxInMemory) error("More elements in memory than the budget allows.");
+    if (_nameBytes < 0) error("The bytes of names in memory are counted below zero.");
+    if (_nameBytes > _maxNameBytes && _heap.size() > 1) error("More bytes of names in memory than the budget allows.");
+    int open = 0;
+    for (const Run& run : _runs) {
+        if (run.file != nullptr) {
+            open++;
+        }
+    }
+    if (open != _heads.size()) error("The merge heap has a different number of heads than there are runs.");
+    if (open > _numOnDisk) error("Fewer elements on disk than runs with elements.");
+    if (_numOnDisk > 0 && open == 0) error("Elements are counted on disk but no run is open.");
+    if (!_heads.isEmpty()) {
+        const Run& best = _runs[_heads.peek().run];
+        if (best.file == nullptr || best.head.priority != _heads.peek().priority) {
+            error("The front of the merge heap does not match its run's head.");
+        }
+    }
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+/* Helper function that makes an empty directory of its own for a test's run files, so the test can
+ * check that every file is deleted. */
+static string emptyTestDirectory(const string& name) {
+    filesystem::path directory = filesystem::temp_directory_path() / name;
+    filesystem::remove_all(directory);
+    filesystem::create_directories(directory);
+    return directory.string();
+}
+
+static bool isEmptyDirectory(const string& directory) {
+    return filesystem::is_empty(filesystem::path(directory));
+}
+
+STUDENT_TEST("ExternalPQHeap: example from writeup with room for four elements, validate each step") {
+    string directory = emptyTestDirectory("pqexternal-example");
+    ExternalPQHeap pq(8 * sizeof(DataPoint), directory);
+    Vector<DataPoint> input = {
+        { "R", 4 }, { "A", 5 }, { "B", 3 }, { "K", 7 }, { "G", 2 },
+        { "V", 9 }, { "T", 1 }, { "O", 8 }, { "S", 6 } };
+
+    pq.validateInternalState();
+    for (DataPoint dp : input) {
+        pq.enqueue(dp);
+        pq.validateInternalState();
+    }
+    EXPECT_EQUAL(pq.size(), 9);
+    EXPECT_EQUAL(pq.numRuns(), 2);
+    EXPECT_EQUAL(pq.sizeOnDisk(), 8);
+    DataPoint expectedFront = { "T", 1 };
+    EXPECT_EQUAL(pq.peek(), expectedFront);
+    for (int expected = 1; expected <= 9; expected++) {
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+        pq.validateInternalState();
+    }
+    EXPECT(pq.isEmpty());
+    EXPECT_EQUAL(pq.numRuns(), 0);
+    EXPECT(isEmptyDirectory(directory));
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peek());
+    EXPECT_ERROR(ExternalPQHeap(sizeof(DataPoint), directory));
+}
+
+STUDENT_TEST("ExternalPQHeap: mixed enqueue and dequeue match PQHeap, names intact") {
+    string directory = emptyTestDirectory("pqexternal-mixed");
+    ExternalPQHeap pq(200 * sizeof(DataPoint), directory);
+    PQHeap reference;
+    setRandomSeed(25);
+    for (int i = 0; i < 20000; i++) {
+        DataPoint dp = { integerToString(i), randomReal(0, 1000) };
+        pq.enqueue(dp);
+        reference.enqueue(dp);
+        if (randomChance(0.4)) {
+            EXPECT_EQUAL(pq.dequeue(), reference.dequeue());
+        }
+    }
+    pq.validateInternalState();
+    EXPECT(pq.numRuns() > 1);
+    EXPECT_EQUAL(pq.size(), reference.size());
+    while (!reference.isEmpty()) {
+        EXPECT_EQUAL(pq.dequeue(), reference.dequeue());
+    }
+    EXPECT(pq.isEmpty());
+    EXPECT(isEmptyDirectory(directory));
+}
+
+STUDENT_TEST("ExternalPQHeap: long names count against the budget, clear deletes every run") {
+    string directory = emptyTestDirectory("pqexternal-names");
+    ExternalPQHeap shortNames(100 * sizeof(DataPoint), directory);
+    ExternalPQHeap longNames(100 * sizeof(DataPoint), directory);
+    for (int i = 0; i < 1000; i++) {
+        shortNames.emplace("", i);
+        longNames.emplace(string(200, 'n') + integerToString(i), i);
+    }
+    EXPECT(longNames.numRuns() > shortNames.numRuns());
+    longNames.validateInternalState();
+    EXPECT_EQUAL(longNames.dequeue().name, string(200, 'n') + "0");
+
+    shortNames.clear();
+    longNames.clear();
+    EXPECT(shortNames.isEmpty() && longNames.isEmpty());
+    EXPECT(isEmptyDirectory(directory));
+    longNames.emplace("after clear", 1);
+    EXPECT_EQUAL(longNames.dequeue().name, "after clear");
+}
+
+STUDENT_TEST("ExternalPQHeap: short names refilled after a spill of long ones keep the name budget") {
+    // Room for 10 elements in memory and 400 bytes of names: seven 50-character names fit, an eighth does not.
+    string directory = emptyTestDirectory("pqexternal-refill");
+    ExternalPQHeap pq(20 * sizeof(DataPoint), directory);
+    string longName(50, 'n');
+    for (int i = 0; i < 8; i++) {
+        pq.emplace(longName, 100 + i);
+        pq.validateInternalState();
+    }
+    EXPECT_EQUAL(pq.numRuns(), 1);
+    for (int i = 1; i <= 9; i++) {
+        pq.emplace("short", i);
+        pq.validateInternalState();
+    }
+    for (int i = 1; i <= 9; i++) {
+        EXPECT_EQUAL(pq.dequeue().name, "short");
+        pq.validateInternalState();
+    }
+
+    // One long name is left in memory, so six more fit and the seventh spills.
+    for (int i = 0; i < 6; i++) {
+        pq.emplace(longName, 200 + i);
+        pq.validateInternalState();
+    }
+    EXPECT_EQUAL(pq.numRuns(), 1);
+    pq.emplace(longName, 300);
+    EXPECT_EQUAL(pq.numRuns(), 2);
+    pq.validateInternalState();
+    pq.clear();
+    EXPECT(isEmptyDirectory(directory));
+}
+
+STUDENT_TEST("ExternalPQHeap: a spill that cannot write its run keeps every element in memory") {
+    string directory = emptyTestDirectory("pqexternal-unwritable");
+    ExternalPQHeap pq(8 * sizeof(DataPoint), (filesystem::path(directory) / "missing").string());
+    for (int i = 4; i >= 1; i--) {
+        pq.emplace(integerToString(i), i);
+    }
+    EXPECT_ERROR(pq.emplace("5", 5));
+    pq.validateInternalState();
+    EXPECT_EQUAL(pq.size(), 4);
+    EXPECT_EQUAL(pq.sizeOnDisk(), 0);
+    for (int expected = 1; expected <= 4; expected++) {
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+    }
+    EXPECT(isEmptyDirectory(directory));
+}
+
+/* Helper functions for the time trial: fill adds n elements of random priority, drain removes them all. */
+template <typename PQ>
+void fillRandom(PQ& pq, int n) {
+    for (int i = 0; i < n; i++) {
+        pq.emplace("", randomReal(0, 1000000));
+    }
+}
+
+template <typename PQ>
+void drainAll(PQ& pq) {
+    while (!pq.isEmpty()) {
+        pq.dequeue();
+    }
+}
+
+STUDENT_TEST("ExternalPQHeap time trial, queues of 1 to 16 times the budget, against PQHeap") {
+    long budget = 32L * 1024 * 1024;
+    int fitsInBudget = int(budget / 2 / sizeof(DataPoint));
+    for (int times = 1; times <= 16; times *= 2) {
+        int n = times * fitsInBudget;
+        cout << "    " << n << " elements, " << times << " times what the in-memory heap holds" << endl;
+        ExternalPQHeap external(budget);
+        TIME_OPERATION(n, fillRandom(external, n));
+        cout << "    " << external.numRuns() << " runs" << endl;
+        TIME_OPERATION(n, drainAll(external));
+        PQHeap heap;
+        TIME_OPERATION(n, fillRandom(heap, n));
+        TIME_OPERATION(n, drainAll(heap));
+    }
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "datapointio.h"
+#include "pqheap.h"
+
+/**
+ * Priority queue of DataPoints, smallest priority first, that keeps its
+ * memory use within a fixed budget however many elements it holds. Elements
+ * that do not fit are spilled to temporary files in sorted runs and read back
+ * as they reach the front.
+ *
+ * New elements go into an in-memory PQHeap. Half of the budget is that heap's
+ * array, allocated once, so it never doubles past the budget; the other half
+ * is for names too long to fit inside a std::string. When either half is
+ * full, the heap is sorted in place and written to a new run file in the
+ * binary DataPoint format of datapointio.h, then cleared. If the run cannot
+ * be written, its file is removed and the elements stay in the heap.
+ *
+ * Runs are merged lazily. Each run's file is memory-mapped, and only its
+ * first unread element, its head, is kept as a DataPoint. A second PQHeap of
+ * small (priority, run) pairs orders the heads, so dequeue compares the front
+ * of the in-memory heap with the best head and takes the more urgent one. The
+ * mapped pages are file cache that the system can drop under memory
+ * pressure, not memory of the process's own. A run's file is deleted once
+ * every element in it has been dequeued.
+ */
+class ExternalPQHeap {
+public:
+    /**
+     * Creates a new, empty priority queue that uses at most memoryBudget
+     * bytes for its elements and writes its runs to the given directory, or
+     * the system's temporary directory if none is given. If the budget does
+     * not leave room for at least two elements, this function calls error().
+     *
+     * @param memoryBudget The most bytes of elements to keep in memory.
+     * @param directory Where to create the run files.
+     */
+    ExternalPQHeap(long memoryBudget, std::string directory = "");
+
+    /**
+     * Deletes every run file and cleans up all memory allocated by this
+     * priority queue.
+     */
+    ~ExternalPQHeap();
+
+    /**
+     * Adds a new element into the queue. This operation runs in time
+     * O(log n), plus a spill of O(m log m) for the m elements in memory
+     * whenever the budget is full.
+     *
+     * @param element The element to add.
+     */
+    void enqueue(const DataPoint& element);
+    void enqueue(DataPoint&& element);
+
+    /**
+     * Adds a new element with the given name and priority into the queue.
+     *
+     * @param name The name of the new element.
+     * @param priority The priority of the new element.
+     */
+    void emplace(std::string name, double priority);
+
+    /**
+     * Removes and returns the element that is frontmost in this priority
+     * queue, whether it is in memory or in a run.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(log n + log r) for r runs.
+     *
+     * @return The frontmost element, which is removed from queue.
+     */
+    DataPoint dequeue();
+
+    /**
+     * Returns, but does not remove, the element that is frontmost.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * @return frontmost element
+     */
+    DataPoint peek() const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue, in memory and on
+     * disk together.
+     */
+    int size() const;
+
+    /**
+     * Returns the count of elements in run files, heads included.
+     */
+    int sizeOnDisk() const;
+
+    /**
+     * Returns the number of runs that still have elements.
+     */
+    int numRuns() const;
+
+    /**
+     * Removes all elements from the priority queue and deletes every run file.
+     */
+    void clear();
+
+    /*
+     * This function exists purely for testing purposes. It prints the
+     * in-memory heap and the head of every run.
+     */
+    void printDebugInfo(std::string msg) const;
+
+    /*
+     * This function exits purely for testing purposes. It verifies that both
+     * heaps are in order, that each run with elements has its head queued,
+     * and that the counts add up.
+     * If a problem is detected, this function calls error().
+     */
+    void validateInternalState() const;
+
+private:
+    /* A spilled run: its mapped file, read up to and including head. */
+    struct Run {
+        std::unique_ptr<MappedDataPointFile> file; // nullptr once the run is used up
+        DataPoint head;                            // first element not yet dequeued
+        std::string path;
+    };
+
+    /* The element of the merge heap: the priority of a run's head and the run's index. */
+    struct RunHead {
+        double priority;
+        int run;
+    };
+
+    struct RunHeadPriority {
+        double operator()(const RunHead& head) const {
+            return head.priority;
+        }
+    };
+
+    PQHeap _heap;                     // elements enqueued since the last spill
+    int _maxInMemory;                 // slots in _heap's array, half of the budget
+    long _maxNameBytes;               // bytes for long names, the other half
+    long _nameBytes;                  // bytes of long names now in _heap
+    std::vector<Run> _runs;           // every run since the last time all were used up
+    BasicPQHeap<RunHead, std::less<>, RunHeadPriority> _heads; // one per run with elements
+    int _numOnDisk;                   // elements in runs, heads included
+    std::string _directory;           // where run files are created
+    std::string _filePrefix;          // start of the name of every run file of this queue
+
+    static long nameBytes(const DataPoint& element); // heap memory used by the name
+    bool headIsNext() const;          // whether the front is a run head rather than in _heap
+    void spill();                     // moves _heap into a new run
+    void closeRun(Run& run);          // unmaps and deletes a run's file
+
+    DISALLOW_COPYING_OF(ExternalPQHeap);
+};
@@ -1,11 +1,14 @@
 /*
  * File Synopsis:
- * The implementation of the Priority Queue Heap is shown here. This file contains 14 functions which are used as helper functions, for testing purposes, or the priority queue methods.
- * In addition, the allocator and deallocator for the priority queue are also in this file. The priority queue heap is essentially a more efficient approach to somewhat sorting an
+ * The Priority Queue Heap is a class template, so its implementation lives in pqheap.h along with the allocator and deallocator.
+ * This file instantiates the DataPoint queue (PQHeap) and contains the tests for it and for queues of other element types.
+ * The priority queue heap is essentially a more efficient approach to somewhat sorting an
  * array of elements compared to the PQArray approach of sorting each individual element.
  */
 
 #include "pqheap.h"
+#include "arenadatapoint.h"
+#include "countingresource.h"
 #include "error.h"
 #include "random.h"
 #include "strlib.h"
@@ -13,254 +16,11 @@
 #include "testing/SimpleTest.h"
 using namespace std;
 
-const int INITIAL_CAPACITY = 10;
-const int NONE = -1; // used as sentinel index
-
-
-/*
- * Synopsis: This is the allocator for the priority queue heap. It initializes the array of elements
- * and other essential variables for the priority queue heap.
- */
-PQHeap::PQHeap(){
-    _numAllocated = INITIAL_CAPACITY;
-    _elements = new DataPoint[_numAllocated](); // allocated zero'd memory
-    _numFilled = 0;
-}
-
-/*
- * Synopsis: This is the deallocator for the priority queue heap. It deletes the leftover array of elements to prevent memory leaks.
- */
-PQHeap::~PQHeap() {
-    delete[] _elements;
-}
-
-/* Function Synopsis:
- * This helper function performs a simple swap of elements within the array for the priority queue.
- * It takes in the parameters of indexes to swap and has no return type since it directly edits the
- * array.
- */
-void PQHeap::swap(int indexA, int indexB) {
-    DataPoint tmp = _elements[indexA];
-    _elements[indexA] = _elements[indexB];
-    _elements[indexB] = tmp;
-}
-
-
-/* Function Synopsis:
- * This helper function takes in one parameter which is an index of an element that was just added
- * or switched around within the priority queue. It runs a series of checks to ensure that the
- * parent-child relationships within the prioirity queue are valid. A boolean representing whether or not
- * the priority queue is properly sorted is returned.
- */
-bool PQHeap::validateHeap(int indexJustAdded){
-    if(indexJustAdded!=0){
-        int parent = getParentIndex(indexJustAdded);
-        if(_elements[parent].priority > _elements[indexJustAdded].priority){
-            return false;
-        }
-    }
-    if(2*indexJustAdded+1 < size()){//left child exists
-        int leftChild = getLeftChildIndex(indexJustAdded);
-        if(_elements[leftChild].priority < _elements[indexJustAdded].priority){
-            return false;
-        }
-    }
-    if(2*indexJustAdded+2 < size()){//right child exists
-        int rightChild = getRightChildIndex(indexJustAdded);
-        if(_elements[rightChild].priority < _elements[indexJustAdded].priority){
-            return false;
-        }
-    }
-    return true;
-}
-
-/*
- * Function Synopsis:
- * This function adds its parameter DataPoint to the end of the priority queue array. It then calls
- * helper functions to properly rearrange the array to ensure it is sorted. Nothing is returned
- * since this is a void function, but the array of elements is directly modified.
- */
-void PQHeap::enqueue(DataPoint elem) {
-    if(_numFilled+1 > _numAllocated){//will not be able to add another element without reaching array size
-        enlargeSize();
-    }
-
-    _elements[_numFilled] = elem;//adds element to last index
-    int temp = _numFilled;
-
-    while(!validateHeap(temp)){//the heap is not in order because of the element just added
-        int toSwap = getParentIndex(temp);
-        swap(temp, toSwap);
-        temp = toSwap;
-    }
-
-    _numFilled++;
-
-}
-
-
-/*
- * Function Synopsis:
- * This is a helper function for enqueue which doubles the size of allocated spaces in the array
- * when it is called. The function takes in no parameters and returns no value since it directly
- * edits the array.
+/* The DataPoint queues are instantiated here so that every member function is compiled
+ * even if no test happens to call it.
  */
-void PQHeap::enlargeSize(){
-    DataPoint* newPQ = new DataPoint[_numAllocated*2];//creates new array with twice the memory of the current array
-    for(int i = 0; i<size(); i++){
-        newPQ[i] = _elements[i];//transfers all data values from the original array to the new one
-    }
-    delete[] _elements;//deallocates the memory from the previous array
-    _elements = newPQ;
-    _numAllocated *= 2;
-
-}
-
-/*
- * Function Synopsis:
- * This function returns the top-most (highest priority) element in the priority queue without removing
- * it from the array. It takes in no parameters.
- */
-DataPoint PQHeap::peek() const {
-    if (isEmpty()) {
-        error("PQueue is empty!");
-    }
-    return(_elements[0]);
-}
-
-/*
- * This function removes and returns the highest priority element from the priority queue. There are
- * no parameters.
- */
-DataPoint PQHeap::dequeue() {
-    DataPoint front = peek();//element at index 0 is stored
-    DataPoint toReplaceFront = _elements[_numFilled-1];
-    _elements[0] = toReplaceFront;//replaces element at first index with last element (it will become empty anyways)
-    int temp = 0;//sets starting value for the while loop, changes as the value being altered moves across the vector
-
-    while(!validateHeap(temp)){
-        int rightChild = getRightChildIndex(temp);
-        int leftChild = getLeftChildIndex(temp);
-        if(_elements[rightChild].priority < _elements[leftChild].priority){//right child needs to move up, its priority is smaller than the left child's priority
-            swap(temp, rightChild);
-            temp = rightChild;
-        }
-        else{//left child needs to move up, its priority is smaller than the right child's priority
-            swap(temp, leftChild);
-            temp = leftChild;
-        }
-    }
-
-    _numFilled--;//The priority queue size decrememnts by 1 since the frontmost item is removed and returned
-    return front;
-}
-
-/*
- * Function Synopsis:
- * This function returns a boolean representing whether or not the array of the priority queue is empty.
- * There are no parameters and the array is not edited.
- */
-bool PQHeap::isEmpty() const {
-    if(size() == 0){
-        return true;
-    }
-    return false;
-}
-
-/*
- * Function Synopsis:
- * This function returns an integer representing the size of the array storing the priority queue's elments.
- * The array is not edited, and there are no parameters.
- */
-int PQHeap::size() const {
-    return _numFilled;
-}
-
-/*
- * Function Synopsis:
- * This function clears the existing array containing the priority queue's elements. The priority queue
- * now contains no elements. There are no parameters and nothing is returned.
- */
-void PQHeap::clear() {
-    _numFilled = 0;
-}
-
-/*
- * Function Synopsis:
- * This function is used for testing purposes, it prints a message then prints out the contents of each
- * array index of the priority queue. Nothing is returned and the only parameter is the string of the message
- * to print.
- */
-void PQHeap::printDebugInfo(string msg) const {
-    cout << msg << endl;
-    for (int i = 0; i < size(); i++) {
-        cout << "[" << i << "] = " << _elements[i] << endl;
-    }
-}
-
-/*
- * Function Synopsis:
- * This function validates the order of the priority queue's array contents by iterating through each
- * index and checking the priority order. An error is thrown containing a description of the index that
- * breaks the order, otherwise this function runs without stopping or returning any values if the array
- * is correctly sorted.
- */
-void PQHeap::validateInternalState() const {
-    for(int i = 0; i<size(); i++){
-        if(getRightChildIndex(i) > -1 ){//the right child exists
-            if((_elements[getRightChildIndex(i)].priority < _elements[i].priority)){//checks priority
-                error("The priority of index " + integerToString(getRightChildIndex(i)) + " has an incorrect priority relationship to its parent.");
-            }
-        }
-        if(getLeftChildIndex(i) > -1){//the left child exists
-            if((_elements[getLeftChildIndex(i)].priority < _elements[i].priority)){//checks priority
-                error("The priority of index " + integerToString(getLeftChildIndex(i)) + " has an incorrect priority relationship to its parent.");
-            }
-        }
-    }
-}
-
-/*
- * Function Synopsis:
- * This helper function calculates the index of the element that is the parent of the
- * specified child index. If this child has no parent, the sentinel value NONE is returned. The only
- * parameter is the index of the child in the array.
- */
-int PQHeap::getParentIndex(int child) const {
-    if(child == 0){
-        return NONE;
-    }
-    int parentIndex = int(((child-1)/2) + 0.5);//previously had it as child-1/2
-    return parentIndex;
-}
-
-/*
- * Function Synopsis:
- * This function calculates the index of the element that is the left child of the
- * specified parent index. If this parent has no left child, the sentinel value NONE is returned.
- * The only parameter is the index of the parent.
- */
-int PQHeap::getLeftChildIndex(int parent) const {
-    if(!(parent*2+1 < size())){
-        return NONE;
-    }
-    int leftChild = 2*parent+1;
-    return leftChild;
-}
-
-/*
- * Function Synopsis:
- * This function calculates the index of the element that is the right child of the
- * specified parent index. If this parent has no right child, the sentinel value NONE is returned.
- * The only parameter is the index of the parent.
- */
-int PQHeap::getRightChildIndex(int parent) const {
-    if(!(parent*2+2 < size())){
-        return NONE;
-    }
-    int rightChild = 2*parent+2;
-    return rightChild;
-}
+template class BasicPQHeap<DataPoint, std::less<>, DataPointPriority>;
+template class BasicPQHeap<DataPoint, std::less<>, DataPointPriority, 4>;
 
 
 /* * * * * * Test Cases Below This Point * * * * * */
@@ -425,6 +185,434 @@ STUDENT_TEST("PQHeap: operations size/isEmpty/clear") {
     EXPECT_EQUAL(pq.size(), 0);
 }
 
+STUDENT_TEST("PQHeap: replaceFront keeps a bounded heap in order") {
+    PQHeap pq(4);
+    for (int i = 1; i <= 4; i++) {
+        pq.enqueue({ "", double(i) });
+    }
+    pq.replaceFront({ "big", 10 });
+    pq.validateInternalState();
+    EXPECT_EQUAL(pq.size(), 4);
+    pq.replaceFront({ "small", 0 });
+    pq.validateInternalState();
+    DataPoint expected = { "small", 0 };
+    EXPECT_EQUAL(pq.dequeue(), expected);
+
+    Vector<double> order;
+    while (!pq.isEmpty()) {
+        order.add(pq.dequeue().priority);
+    }
+    Vector<double> expectedOrder = { 3, 4, 10 };
+    EXPECT_EQUAL(order, expectedOrder);
+    EXPECT_ERROR(pq.replaceFront({ "", 1 }));
+}
+
+/* Helper functions for the time trials: enqueue n random priorities, then dequeue n. */
+template <typename PQ>
+void fillHeap(PQ& pq, int n) {
+    for (int i = 0; i < n; i++) {
+        pq.enqueue(randomReal(0, 10));
+    }
+}
+
+template <typename PQ>
+void emptyHeap(PQ& pq, int n) {
+    for (int i = 0; i < n; i++) {
+        pq.dequeue();
+    }
+}
+
+STUDENT_TEST("siftUp/siftDown: heapify and drain a plain array, heapify an empty one") {
+    Vector<int> values = { 9, 4, 7, 1, 8, 2, 6, 3, 5, 0 };
+    int n = values.size();
+    int* elements = &values[0];
+    auto lessThan = [](int a, int b) { return a < b; };
+    for (int i = 1; i < n; i++) {
+        siftUp(elements, i, lessThan);
+    }
+    for (int expected = 0; expected < 10; expected++) {
+        EXPECT_EQUAL(elements[0], expected);
+        n--;
+        elements[0] = elements[n];
+        siftDown(elements, 0, n, lessThan);
+    }
+
+    int* none = nullptr;   // an empty array is never read, whatever the arity
+    heapify<4>(none, 0, lessThan);
+    heapify<8>(none, 0, lessThan);
+}
+
+STUDENT_TEST("PQHeap built from a vector, validate and drain in order") {
+    setRandomSeed(137);
+    for (int n = 0; n <= 1000; n = n * 3 + 1) {
+        Vector<DataPoint> input;
+        for (int i = 0; i < n; i++) {
+            input.add({ "", double(randomInteger(-100, 100)) });
+        }
+        PQHeap pq(input);
+        pq.validateInternalState();
+        EXPECT_EQUAL(pq.size(), n);
+
+        DAryPQHeap<4> pq4;
+        pq4.enqueue({ "replaced", -1000 });
+        pq4.buildFrom(input.begin(), input.end());
+        pq4.validateInternalState();
+
+        sort(input.begin(), input.end(), [](const DataPoint& a, const DataPoint& b) { return a.priority < b.priority; });
+        for (int i = 0; i < n; i++) {
+            EXPECT_EQUAL(pq.dequeue().priority, input[i].priority);
+            EXPECT_EQUAL(pq4.dequeue().priority, input[i].priority);
+        }
+        EXPECT(pq4.isEmpty());
+    }
+}
+
+STUDENT_TEST("PQHeap: enqueueAll sifts small batches in and rebuilds for large ones, rebuild threshold") {
+    setRandomSeed(19);
+    PQHeap pq;
+    Vector<double> all;
+    for (int batchSize : { 5, 1, 40, 3, 200, 0, 7 }) {
+        Vector<DataPoint> batch;
+        for (int i = 0; i < batchSize; i++) {
+            batch.add({ "", double(randomInteger(-50, 50)) });
+            all.add(batch[i].priority);
+        }
+        pq.enqueueAll(batch.begin(), batch.end());
+        pq.validateInternalState();
+        EXPECT_EQUAL(pq.size(), all.size());
+    }
+    sort(all.begin(), all.end());
+    for (double expected : all) {
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+    }
+    EXPECT(pq.isEmpty());
+    EXPECT_ERROR(pq.setRebuildThreshold(-1));
+}
+
+STUDENT_TEST("PQHeap: dequeueMany drains into a buffer, most urgent first") {
+    BasicPQHeap<int> pq;
+    for (int i = 0; i < 100; i++) {
+        pq.enqueue((i * 37) % 100);
+    }
+    Vector<int> out(120);
+    EXPECT_EQUAL(pq.dequeueMany(30, &out[0]), 30);
+    pq.validateInternalState();
+    EXPECT_EQUAL(pq.dequeueMany(120, &out[30]), 70);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQUAL(out[i], i);
+    }
+    EXPECT(pq.isEmpty());
+    EXPECT_EQUAL(pq.dequeueMany(1, &out[0]), 0);
+}
+
+STUDENT_TEST("PQHeap: sortInPlace leaves every element queued, most urgent first") {
+    DAryPQHeap<4> pq;
+    for (int i = 0; i < 100; i++) {
+        pq.emplace(integerToString(i), double((i * 37) % 50));
+    }
+    const DataPoint* sorted = pq.sortInPlace();
+    for (int i = 1; i < pq.size(); i++) {
+        EXPECT(sorted[i - 1].priority <= sorted[i].priority);
+    }
+    pq.validateInternalState();
+    EXPECT_EQUAL(pq.size(), 100);
+    EXPECT_EQUAL(pq.dequeue().priority, 0);
+    pq.validateInternalState();
+}
+
+/* Helper function for the crossover trial: adds a batch to a heap whose array already has room for it,
+ * so only the sifting or rebuilding is timed. */
+void addBatch(BasicPQHeap<double>& pq, const Vector<double>& batch) {
+    pq.enqueueAll(batch.begin(), batch.end());
+}
+
+STUDENT_TEST("PQHeap time trial, enqueueAll crossover between sifting up and rebuilding") {
+    int n = 1000000;
+    Vector<double> start;
+    for (int i = 0; i < n; i++) {
+        start.add(randomReal(0, 10));
+    }
+    for (int k = n / 64; k <= 8 * n; k *= 4) {
+        Vector<double> random;
+        Vector<double> decreasing;  // each more urgent than everything queued, the worst case for sifting up
+        for (int i = 0; i < k; i++) {
+            random.add(randomReal(0, 10));
+            decreasing.add(-i);
+        }
+        for (const Vector<double>* batch : { &random, &decreasing }) {
+            cout << "    queue of " << n << ", batch of " << k << (batch == &random ? " random" : " decreasing")
+                 << " priorities, sifting up then rebuilding" << endl;
+            BasicPQHeap<double> sifted(start);
+            BasicPQHeap<double> rebuilt(start);
+            sifted.reserve(n + k);
+            rebuilt.reserve(n + k);
+            sifted.setRebuildThreshold(1e18);
+            rebuilt.setRebuildThreshold(0);
+            TIME_OPERATION(k, addBatch(sifted, *batch));
+            TIME_OPERATION(k, addBatch(rebuilt, *batch));
+        }
+    }
+}
+
+/* Helper functions for the dequeueMany trial, which drain a heap into a buffer one dequeue at a time
+ * or all at once. */
+void drainOneAtATime(PQHeap& pq, Vector<DataPoint>& out) {
+    for (int i = 0; !pq.isEmpty(); i++) {
+        out[i] = pq.dequeue();
+    }
+}
+
+void drainAtOnce(PQHeap& pq, Vector<DataPoint>& out) {
+    pq.dequeueMany(pq.size(), &out[0]);
+}
+
+STUDENT_TEST("PQHeap time trial, dequeue loop versus dequeueMany") {
+    for (int n = 100000; n <= 1000000; n *= 10) {
+        Vector<DataPoint> input;
+        for (int i = 0; i < n; i++) {
+            input.add({ "", randomReal(0, 10) });
+        }
+        Vector<DataPoint> out(n);
+        PQHeap looped(input);
+        PQHeap many(input);
+        TIME_OPERATION(n, drainOneAtATime(looped, out));
+        TIME_OPERATION(n, drainAtOnce(many, out));
+    }
+}
+
+/* Helper function that builds a heap of n random priorities all at once. */
+void buildHeap(BasicPQHeap<double>& pq, const Vector<double>& values) {
+    pq.buildFrom(values.begin(), values.end());
+}
+
+STUDENT_TEST("PQHeap time trial, bottom-up build versus n enqueues") {
+    for (int n = 1000000; n <= 10000000; n *= 3) {
+        Vector<double> values;
+        for (int i = 0; i < n; i++) {
+            values.add(randomReal(0, 10));
+        }
+        BasicPQHeap<double> oneAtATime;
+        BasicPQHeap<double> bulk;
+        TIME_OPERATION(n, fillHeap(oneAtATime, n));
+        TIME_OPERATION(n, buildHeap(bulk, values));
+    }
+}
+
+STUDENT_TEST("PQHeap: reserve, growth factor, shrink on dequeue and shrinkToFit") {
+    PQHeap pq;
+    pq.reserve(1000);
+    for (int i = 0; i < 1000; i++) {
+        pq.enqueue({ "", double(i % 37) });
+    }
+    EXPECT_EQUAL(pq.getResizeStats().reallocations, 1);
+    EXPECT_EQUAL(pq.getResizeStats().bytesCopied, 0);
+    while (!pq.isEmpty()) {
+        pq.dequeue();
+    }
+    EXPECT_EQUAL(pq.getResizeStats().reallocations, 1);
+
+    BasicPQHeap<int> heap;
+    heap.setGrowthFactor(1.5);
+    for (int i = 0; i < 1000; i++) {
+        heap.enqueue(1000 - i);
+    }
+    ResizeStats grown = heap.getResizeStats();
+    EXPECT(grown.reallocations > 9);
+    EXPECT(grown.bytesCopied > 1000 * long(sizeof(int)));
+    EXPECT_ERROR(heap.setGrowthFactor(0.5));
+
+    for (int i = 1; i <= 900; i++) {
+        EXPECT_EQUAL(heap.dequeue(), i);
+    }
+    heap.validateInternalState();
+    long shrinks = heap.getResizeStats().reallocations - grown.reallocations;
+    EXPECT(shrinks >= 1);
+    for (int i = 0; i < 100; i++) {
+        heap.enqueue(0);
+        heap.dequeue();
+    }
+    EXPECT_EQUAL(heap.getResizeStats().reallocations, grown.reallocations + shrinks);
+
+    heap.setShrinkOnDequeue(false);
+    heap.shrinkToFit();
+    EXPECT_EQUAL(heap.size(), 100);
+    for (int i = 901; i <= 1000; i++) {
+        EXPECT_EQUAL(heap.dequeue(), i);
+    }
+}
+
+/* Helper function that enqueues n values into a heap with the given growth factor,
+ * optionally reserving first, and reports how much resizing it took. */
+void reportResizing(int n, double growthFactor, bool reserveFirst) {
+    BasicPQHeap<double> pq;
+    pq.setGrowthFactor(growthFactor);
+    if (reserveFirst) {
+        pq.reserve(n);
+    }
+    fillHeap(pq, n);
+    ResizeStats stats = pq.getResizeStats();
+    cout << "    growth " << growthFactor << (reserveFirst ? ", reserved" : "") << ": "
+         << stats.reallocations << " reallocations, " << stats.bytesCopied / 1024 << " KiB copied" << endl;
+}
+
+STUDENT_TEST("PQHeap resize instrumentation, growth factors and reserve at 10^6 elements") {
+    int n = 1000000;
+    reportResizing(n, 1.5, false);
+    reportResizing(n, 2, false);
+    reportResizing(n, 4, false);
+    reportResizing(n, 2, true);
+}
+
+STUDENT_TEST("PQHeap time trial, enqueue/dequeue 10^6 to 10^7 elements") {
+    for (int n = 1000000; n <= 10000000; n *= 3) {
+        BasicPQHeap<double> pq(n);
+        TIME_OPERATION(n, fillHeap(pq, n));
+        TIME_OPERATION(n, emptyHeap(pq, n));
+    }
+}
+
+/* Helper function that runs the dequeue time trial for one heap arity and queue size. */
+template <int Arity>
+void timeDequeueWithArity(int n) {
+    BasicPQHeap<double, less<>, IdentityKey, Arity> pq(n);
+    fillHeap(pq, n);
+    cout << "    arity " << Arity << ", " << n * sizeof(double) / 1024 << " KiB of priorities" << endl;
+    TIME_OPERATION(n, emptyHeap(pq, n));
+}
+
+STUDENT_TEST("DAryPQHeap: 4-ary and 8-ary heaps dequeue in order") {
+    DAryPQHeap<4> pq4;
+    DAryPQHeap<8> pq8;
+    setRandomSeed(106);
+    for (int i = 0; i < 1000; i++) {
+        DataPoint elem = { "", double(randomInteger(-50, 50)) };
+        pq4.enqueue(elem);
+        pq8.enqueue(elem);
+    }
+    pq4.validateInternalState();
+    pq8.validateInternalState();
+    double last4 = -100, last8 = -100;
+    while (!pq4.isEmpty()) {
+        DataPoint front4 = pq4.dequeue();
+        DataPoint front8 = pq8.dequeue();
+        EXPECT(front4.priority >= last4);
+        EXPECT(front8.priority >= last8);
+        last4 = front4.priority;
+        last8 = front8.priority;
+    }
+    EXPECT(pq8.isEmpty());
+}
+
+STUDENT_TEST("DAryPQHeap time trial, dequeue with arity 2/4/8 past L2 and L3 sizes") {
+    // 2^15 doubles is 256 KiB (fits in L2), 2^19 is 4 MiB (past L2) and
+    // 2^23 is 64 MiB (past L3).
+    for (int n = 1 << 15; n <= 1 << 23; n <<= 2) {
+        timeDequeueWithArity<2>(n);
+        timeDequeueWithArity<4>(n);
+        timeDequeueWithArity<8>(n);
+    }
+}
+
+/* Small record type used to test heaps of elements that are not DataPoints. */
+struct Job {
+    int id;
+    long long deadline;
+};
+
+struct JobDeadline {
+    long long operator()(const Job& job) const {
+        return job.deadline;
+    }
+};
+
+STUDENT_TEST("BasicPQHeap: queue of ints, smallest first") {
+    BasicPQHeap<int> pq;
+    Vector<int> input = { 5, 3, 9, 1, 7, 3, 8, 2, 6, 4, 0, 11 };
+    for (int value : input) {
+        pq.enqueue(value);
+        pq.validateInternalState();
+    }
+    input.sort();
+    for (int i = 0; i < input.size(); i++) {
+        EXPECT_EQUAL(pq.dequeue(), input[i]);
+        pq.validateInternalState();
+    }
+    EXPECT_ERROR(pq.peek());
+}
+
+STUDENT_TEST("BasicPQHeap: 64-bit timestamps with greater comparator, largest first") {
+    BasicPQHeap<long long, greater<>> pq;
+    long long base = 1LL << 40;
+    for (int i = 0; i < 100; i++) {
+        pq.enqueue(base + (i * 37) % 100);
+    }
+    for (int i = 99; i >= 0; i--) {
+        EXPECT_EQUAL(pq.dequeue(), base + i);
+    }
+}
+
+STUDENT_TEST("BasicPQHeap: struct elements ordered by a key function") {
+    BasicPQHeap<Job, less<>, JobDeadline> pq;
+    pq.enqueue({ 1, 300 });
+    pq.enqueue({ 2, 100 });
+    pq.enqueue({ 3, 200 });
+    pq.validateInternalState();
+    EXPECT_EQUAL(pq.dequeue().id, 2);
+    EXPECT_EQUAL(pq.dequeue().id, 3);
+    EXPECT_EQUAL(pq.dequeue().id, 1);
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("ArenaPQHeap: array and long names all come from the arena") {
+    // The arena has no upstream, so any allocation that does not fit in the buffer throws.
+    Vector<char> buffer(1 << 18);
+    std::pmr::monotonic_buffer_resource arena(&buffer[0], buffer.size(), std::pmr::null_memory_resource());
+    {
+        ArenaPQHeap pq(&arena, 16, true);
+        for (int i = 0; i < 200; i++) {
+            pq.emplace("a name much too long for the small string buffer #" + integerToString(i), double((i * 13) % 200));
+        }
+        pq.enqueue(ArenaDataPoint(DataPoint{ "converted from a DataPoint with a long name", -1 }));
+        pq.validateInternalState();
+        EXPECT(pq.getResizeStats().reallocations > 0);
+
+        ArenaDataPoint front = pq.dequeue();
+        EXPECT_EQUAL(front.toDataPoint().name, "converted from a DataPoint with a long name");
+        for (int i = 0; i < 100; i++) {
+            EXPECT_EQUAL(pq.dequeue().priority, i);
+        }
+        pq.validateInternalState();
+        // the remaining 100 elements are never destroyed one by one; the arena reclaims them
+    }
+
+    BasicPQHeap<int> ints(&arena, 4);
+    for (int i = 10; i > 0; i--) {
+        ints.enqueue(i);
+    }
+    for (int i = 1; i <= 10; i++) {
+        EXPECT_EQUAL(ints.dequeue(), i);
+    }
+}
+
+STUDENT_TEST("ArenaPQHeap: on a general resource, teardown gives every byte back unless skipped") {
+    CountingResource counting;
+    {
+        ArenaPQHeap pq(&counting);
+        for (int i = 0; i < 200; i++) {
+            pq.emplace("a name much too long for the small string buffer #" + integerToString(i), double(i));
+        }
+        EXPECT(counting.bytesInUse() > 0);
+    }
+    EXPECT_EQUAL(counting.bytesInUse(), 0);
+
+    {
+        BasicPQHeap<int> ints(&counting, 64);
+        ints.enqueue(1);
+    }
+    EXPECT_EQUAL(counting.bytesInUse(), 0);
+    EXPECT_ERROR(PQHeap(&counting, 16, true));
+}
+
 PROVIDED_TEST("PQHeap example from writeup of PQArray") {
     PQHeap pq;
 
@@ -1,21 +1,300 @@
 #pragma once
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include "testing/MemoryUtils.h"
 #include "datapoint.h"
+#include "error.h"
+#include "strlib.h"
+#include "vector.h"
+#include "pqresize.h"
 
 /**
- * Priority queue of DataPoints implemented using a binary heap.
+ * Key function that uses each element as its own priority. This is the
+ * default for queues of plain values such as int or long long.
+ *
+ * A key function may also have a set member that writes a new priority into
+ * an element; queues that change priorities in place (such as
+ * BasicAddressablePQHeap) need it.
+ */
+struct IdentityKey {
+    template <typename T>
+    const T& operator()(const T& element) const {
+        return element;
+    }
+
+    template <typename T>
+    void set(T& element, const T& key) const {
+        element = key;
+    }
+};
+
+/**
+ * Key function that reads (and writes) the priority of a DataPoint.
+ */
+struct DataPointPriority {
+    double operator()(const DataPoint& element) const {
+        return element.priority;
+    }
+
+    void set(DataPoint& element, double priority) const {
+        element.priority = priority;
+    }
+};
+
+/**
+ * The default for the onPlace argument of siftUp and siftDown, which does
+ * nothing. It is inlined away, so heaps that do not track positions pay
+ * nothing for the hook.
+ */
+struct IgnorePlacement {
+    void operator()(int) const {}
+};
+
+/**
+ * Builds a DataPoint from a name and a priority. Taking the priority as a
+ * double parameter lets an int argument convert as in any function call,
+ * where brace-initializing the aggregate would narrow it.
+ */
+inline DataPoint makeDataPoint(std::string name, double priority) {
+    return { std::move(name), priority };
+}
+
+/**
+ * Builds an element of type T from the arguments of an emplace. Types with a
+ * matching constructor are built with parentheses and DataPoints through
+ * makeDataPoint; any other aggregate is brace-initialized.
+ */
+template <typename T, typename... Args>
+T buildElement(Args&&... args) {
+    if constexpr (std::is_constructible<T, Args&&...>::value) {
+        return T(std::forward<Args>(args)...);
+    } else if constexpr (std::is_same<T, DataPoint>::value) {
+        return makeDataPoint(std::forward<Args>(args)...);
+    } else {
+        return T{std::forward<Args>(args)...};
+    }
+}
+
+/**
+ * Moves the element at index towards the root of the Arity-ary heap stored in
+ * elements[0 .. index] until its parent is at least as urgent. Rather than
+ * swapping at every level, the element is lifted out, less urgent parents are
+ * moved down into the hole it leaves, and the element is placed once at the
+ * end, so each level costs one comparison and one move.
+ *
+ * isMoreUrgent(a, b) returns true if element a belongs in front of b.
+ * onPlace(i) is called every time an element is written to elements[i], so a
+ * heap can keep an index of where each element is.
+ * This operation runs in time O(log n).
+ */
+template <int Arity = 2, typename T, typename IsMoreUrgent, typename OnPlace = IgnorePlacement>
+void siftUp(T* elements, int index, IsMoreUrgent isMoreUrgent, OnPlace onPlace = {}) {
+    T moving = std::move(elements[index]);
+    while (index > 0) {
+        int parent = (index - 1) / Arity;
+        if (!isMoreUrgent(moving, elements[parent])) {
+            break;
+        }
+        elements[index] = std::move(elements[parent]);
+        onPlace(index);
+        index = parent;
+    }
+    elements[index] = std::move(moving);
+    onPlace(index);
+}
+
+/**
+ * Moves the element at index away from the root of the Arity-ary heap stored
+ * in elements[0 .. count-1] until no child is more urgent than it. The hole
+ * left by the element moves down one level at a time, each time filled by the
+ * most urgent child, and the element is placed once where the hole stops.
+ * The children of a node are adjacent in the array, so a wider heap does more
+ * comparisons per level but touches fewer levels (and cache lines) overall.
+ *
+ * isMoreUrgent(a, b) returns true if element a belongs in front of b, and
+ * onPlace(i) is called every time an element is written to elements[i].
+ * This operation runs in time O(log n).
  */
-class PQHeap {
+template <int Arity = 2, typename T, typename IsMoreUrgent, typename OnPlace = IgnorePlacement>
+void siftDown(T* elements, int index, int count, IsMoreUrgent isMoreUrgent, OnPlace onPlace = {}) {
+    T moving = std::move(elements[index]);
+    int firstChild = Arity * index + 1;
+    while (firstChild < count) {
+        int best = firstChild;
+        int endChild = std::min(firstChild + Arity, count);
+        for (int child = firstChild + 1; child < endChild; child++) {
+            if (isMoreUrgent(elements[child], elements[best])) {
+                best = child;
+            }
+        }
+        if (!isMoreUrgent(elements[best], moving)) {
+            break;
+        }
+        elements[index] = std::move(elements[best]);
+        onPlace(index);
+        index = best;
+        firstChild = Arity * index + 1;
+    }
+    elements[index] = std::move(moving);
+    onPlace(index);
+}
+
+/**
+ * Rearranges elements[0 .. count-1] into an Arity-ary heap bottom-up (Floyd's
+ * method): every node that has children is sifted down, starting from the
+ * last one and working back to the root. Most nodes are near the bottom and
+ * move only a level or two, so this runs in time O(n) rather than the
+ * O(n log n) of enqueuing the elements one at a time.
+ *
+ * isMoreUrgent(a, b) returns true if element a belongs in front of b. Fewer
+ * than two elements are already a heap and are not touched.
+ */
+template <int Arity = 2, typename T, typename IsMoreUrgent>
+void heapify(T* elements, int count, IsMoreUrgent isMoreUrgent) {
+    if (count < 2) {
+        return;   // (count - 2) / Arity truncates to 0 here, which would sift an empty array
+    }
+    for (int i = (count - 2) / Arity; i >= 0; i--) {
+        siftDown<Arity>(elements, i, count, isMoreUrgent);
+    }
+}
+
+/**
+ * Allocates an array with room for count elements plus padding unused slots in
+ * front, aligned to a 64-byte cache line, and returns a pointer to index 0 just
+ * past the padding. Every slot past the padding holds a value-initialized
+ * element, like new T[count](). A heap of arity d that uses d-1 padding slots
+ * has the children of node p (indexes d*p+1 through d*p+d) starting at slot
+ * d*(p+1) of the block, so each group of children is aligned.
+ *
+ * The block comes from the given memory resource (by default the general
+ * heap). Elements that use a std::pmr allocator, such as ArenaDataPoint, are
+ * constructed with that resource too, so whatever they allocate later comes
+ * from the same place.
+ */
+template <typename T>
+T* allocateAlignedArray(int count, int padding,
+                        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    size_t alignment = std::max<size_t>(64, alignof(T));
+    void* block = resource->allocate(sizeof(T) * (count + padding), alignment);
+    T* slots = static_cast<T*>(block) + padding;
+    std::pmr::polymorphic_allocator<T> allocator(resource);
+    for (int i = 0; i < count; i++) {
+        allocator.construct(slots + i);
+    }
+    return slots;
+}
+
+/**
+ * Destroys the count elements of an array made by allocateAlignedArray with
+ * the same padding and hands its block back to the same memory resource.
+ */
+template <typename T>
+void freeAlignedArray(T* slots, int count, int padding,
+                      std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    for (int i = 0; i < count; i++) {
+        slots[i].~T();
+    }
+    size_t alignment = std::max<size_t>(64, alignof(T));
+    resource->deallocate(slots - padding, sizeof(T) * (count + padding), alignment);
+}
+
+/**
+ * True for element types that give nothing back when destroyed except memory
+ * taken from their own std::pmr resource: trivially destructible types, and
+ * allocator-aware types such as ArenaDataPoint. A queue of such elements that
+ * lives in a monotonic arena can skip its destructors entirely, since
+ * releasing the arena frees everything at once.
+ */
+template <typename T>
+constexpr bool releasedWithArena = std::is_trivially_destructible<T>::value
+        || std::uses_allocator<T, std::pmr::polymorphic_allocator<char>>::value;
+
+/**
+ * Priority queue of elements of type T implemented using a heap in which each
+ * node has Arity children (a binary heap by default).
+ *
+ * KeyFn maps an element to its priority and Compare orders two priorities,
+ * returning true when the first is more urgent. Both are template parameters,
+ * so the comparisons in the heap are resolved (and usually inlined) at
+ * compile time. With the defaults, the smallest value is frontmost.
+ *
+ * The array is aligned to a cache line and shifted so that the Arity children
+ * of every node start on a multiple of Arity slots from that boundary. When
+ * Arity elements fill a cache line (e.g. 8 doubles), the children compared at
+ * each level of a dequeue sit in a single line.
+ *
+ * A queue can also be given a std::pmr::memory_resource (an arena such as a
+ * monotonic or pool resource) to take its array from instead of the general
+ * heap; see the arena constructor below.
+ *
+ * The array grows without limit. For queues of DataPoints that may not fit in
+ * memory, ExternalPQHeap in pqexternal.h spills sorted runs to disk instead.
+ *
+ * The whole class is defined in this header since it is a template. The
+ * priority queue of DataPoints is the PQHeap alias at the bottom of the file.
+ */
+template <typename T, typename Compare = std::less<>, typename KeyFn = IdentityKey, int Arity = 2>
+class BasicPQHeap {
+    static_assert(Arity >= 2, "A heap node needs at least two children");
+
 public:
     /**
      * Creates a new, empty priority queue.
      */
-    PQHeap();
+    BasicPQHeap();
+
+    /**
+     * Creates a new, empty priority queue with room for capacity elements
+     * allocated up front, so that the first capacity enqueues never resize
+     * the array.
+     *
+     * @param capacity The number of slots to allocate.
+     */
+    BasicPQHeap(int capacity);
+
+    /**
+     * Creates a priority queue holding a copy of every element of the given
+     * vector. The array is allocated once at the right size and arranged into
+     * a heap bottom-up, which runs in time O(n).
+     *
+     * @param elements The elements to start with.
+     */
+    BasicPQHeap(const Vector<T>& elements);
+
+    /**
+     * Creates a new, empty priority queue whose array, and every copy of it
+     * made while resizing, comes from the given arena instead of the general
+     * heap. For allocator-aware elements such as ArenaDataPoint, the elements
+     * in the array and the ones built by enqueue and emplace use the arena as
+     * well, so once the arena has warmed up an enqueue never calls malloc.
+     *
+     * By default, destroying the queue destroys its elements and hands the
+     * array back to the arena, as for any other resource. If skipTeardown is
+     * true, destroying the queue runs no destructors and frees nothing, which
+     * takes time O(1). That is only safe with a monotonic arena, such as a
+     * std::pmr::monotonic_buffer_resource, which reclaims everything at once
+     * when it is released or destroyed; with a pool or the general heap the
+     * memory would leak. It also requires elements that are releasedWithArena,
+     * or else this function calls error(). The arena must outlive the queue.
+     *
+     * @param arena The memory resource to allocate from.
+     * @param capacity The number of slots to allocate up front.
+     * @param skipTeardown Whether to leave all teardown to a monotonic arena.
+     */
+    BasicPQHeap(std::pmr::memory_resource* arena, int capacity = INITIAL_CAPACITY, bool skipTeardown = false);
 
     /**
      * Cleans up all memory allocated by this priority queue.
      */
-    ~PQHeap();
+    ~BasicPQHeap();
 
     /**
      * Adds a new element into the queue. This operation runs in time O(log n),
@@ -23,7 +302,50 @@ public:
      *
      * @param element The element to add.
      */
-    void enqueue(DataPoint element);
+    void enqueue(const T& element);
+
+    /**
+     * Adds a new element into the queue, moving it in rather than copying it.
+     * This operation runs in time O(log n).
+     *
+     * @param element The element to add, which is left in a moved-from state.
+     */
+    void enqueue(T&& element);
+
+    /**
+     * Adds a new element into the queue, constructing it from the given
+     * arguments, e.g. pq.emplace("name", 3.5) for a queue of DataPoints.
+     * This operation runs in time O(log n).
+     *
+     * @param args The arguments used to brace-initialize the element.
+     */
+    template <typename... Args>
+    void emplace(Args&&... args);
+
+    /**
+     * Replaces the contents of the queue with the elements in the range
+     * [first, last), e.g. pointers into an array or move iterators. The array
+     * is resized at most once and the heap is built bottom-up in time O(n).
+     *
+     * @param first Iterator to the first element to add.
+     * @param last Iterator just past the last element to add.
+     */
+    template <typename Iterator>
+    void buildFrom(Iterator first, Iterator last);
+
+    /**
+     * Adds every element in the range [first, last) to the queue, e.g. a
+     * batch collected by BasicBufferedPQHeap. The array is resized at most
+     * once. A batch of k elements that is small next to the n already queued
+     * is sifted up element by element, in time O(k log n); a larger one is
+     * appended and the whole array is rebuilt bottom-up, in time O(n + k).
+     * See setRebuildThreshold for where one gives way to the other.
+     *
+     * @param first Iterator to the first element to add.
+     * @param last Iterator just past the last element to add.
+     */
+    template <typename Iterator>
+    void enqueueAll(Iterator first, Iterator last);
 
     /**
      * Removes and returns the element that is frontmost in this priority queue.
@@ -31,7 +353,8 @@ public:
      * of 1 is more urgent than priority 2 which is more urgent than priority 7
      * and so on. If the priority queue contains two or more elements of equal
      * priority, the order those elements are dequeued is arbitrary, i.e. there
-     * is no required tie-break handling.
+     * is no required tie-break handling. BasicStablePQHeap (pqstable.h) is the
+     * variant that dequeues them in the order they were enqueued.
      *
      * If the priority queue is empty, this function calls error().
      *
@@ -39,7 +362,49 @@ public:
      *
      * @return The frontmost element, which is removed from queue.
      */
-    DataPoint dequeue();
+    T dequeue();
+
+    /**
+     * Removes the k frontmost elements and moves them, most urgent first,
+     * into out[0] .. out[k-1], which the caller must have room for. If fewer
+     * than k elements are queued, all of them are removed. Nothing is copied
+     * and the array is shrunk at most once, at the end.
+     *
+     * This operation runs in time O(k log n).
+     *
+     * @param k The most elements to remove.
+     * @param out The buffer that receives them.
+     * @return The number of elements removed.
+     */
+    int dequeueMany(int k, T* out);
+
+    /**
+     * Sorts the elements in place, most urgent first, and returns a pointer to
+     * the first of them. An array in sorted order is still a heap, so every
+     * element stays queued and the queue can be used as before. The pointer
+     * is valid until the queue next changes.
+     *
+     * This operation runs in time O(n log n) and allocates no memory.
+     *
+     * @return The elements, size() of them, in the order dequeue would return them.
+     */
+    const T* sortInPlace();
+
+    /**
+     * Replaces the frontmost element with the given element in a single step.
+     * This behaves like a dequeue followed by an enqueue, but the array never
+     * changes size, so a queue used this way acts as a bounded (fixed-capacity)
+     * heap. The new element does not need to be more urgent than the one it
+     * replaces.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(log n).
+     *
+     * @param element The element that takes the place of the frontmost one.
+     */
+    void replaceFront(const T& element);
+    void replaceFront(T&& element);
 
     /**
      * Returns, but does not remove, the element that is frontmost.
@@ -50,7 +415,7 @@ public:
      *
      * @return frontmost element
      */
-    DataPoint peek() const;
+    T peek() const;
 
     /**
      * Returns whether this priority queue is empty.
@@ -71,12 +436,80 @@ public:
     int size() const;
 
     /**
-     * Removes all elements from the priority queue.
+     * Removes all elements from the priority queue. The array keeps its
+     * current capacity; call shrinkToFit afterwards to release it.
      *
      * This operation must run in time O(1).
      */
     void clear();
 
+    /**
+     * Makes sure the array has room for at least capacity elements, so that
+     * a known number of enqueues never resizes it. The capacity also becomes
+     * the floor below which the array does not shrink automatically.
+     *
+     * This operation runs in time O(n) if the array is replaced.
+     *
+     * @param capacity The number of elements to make room for.
+     */
+    void reserve(int capacity);
+
+    /**
+     * Replaces the array by one just big enough for the current elements and
+     * cancels any earlier reserve.
+     *
+     * This operation runs in time O(n).
+     */
+    void shrinkToFit();
+
+    /**
+     * Sets the factor the array grows by when it is full (2 by default). The
+     * same factor sets when dequeue shrinks it, see shrunkCapacity in
+     * pqresize.h. If factor is not greater than 1, this function calls error().
+     *
+     * @param factor The new growth factor.
+     */
+    void setGrowthFactor(double factor);
+
+    /**
+     * Turns automatic shrinking on dequeue on (the default) or off. With it
+     * on, dequeue may replace the array by a smaller one, which keeps its
+     * amortized running time O(log n).
+     *
+     * @param enabled Whether dequeue may shrink the array.
+     */
+    void setShrinkOnDequeue(bool enabled);
+
+    /**
+     * Sets when enqueueAll rebuilds the heap instead of sifting each new
+     * element up: when the batch has at least fraction times as many
+     * elements as are already queued. The default of 1 comes from the
+     * crossover trial in pqheap.cpp. A fraction of 0 always rebuilds and
+     * a very large one never does. If fraction is negative, this function
+     * calls error().
+     *
+     * @param fraction The batch size, relative to the queue, that rebuilds.
+     */
+    void setRebuildThreshold(double fraction);
+
+    /**
+     * Returns the number of times the array has been replaced and the number
+     * of bytes of elements moved from old arrays into new ones.
+     *
+     * @return The resize counts for this queue.
+     */
+    ResizeStats getResizeStats() const;
+
+    /**
+     * Returns the number of elements this queue has copied in, by enqueue or
+     * replaceFront of an lvalue, rather than moved. Each copy of a DataPoint
+     * whose name is too long for the string's own buffer allocates a new one,
+     * so the allocation benchmarks in pqclient.cpp read this count.
+     *
+     * @return The number of elements copied in.
+     */
+    long getCopyCount() const;
+
     /*
      * This function exists purely for testing purposes. You can have it do whatever you'd
      * like and we won't be invoking it when grading. In the past, students have had this
@@ -94,18 +527,47 @@ public:
     void validateInternalState() const;
 
 private:
+    static constexpr int INITIAL_CAPACITY = 10;
+    static constexpr int NONE = -1; // used as sentinel index
+    static constexpr int PADDING = Arity - 1; // unused slots in front of index 0 that align each group of children
 
     int getParentIndex(int child) const;
-    int getLeftChildIndex(int parent) const;
-    int getRightChildIndex(int parent) const;
 
-    DataPoint* _elements;   // dynamic array
+    T* _elements;           // dynamic array
     int _numAllocated;      // number of slots allocated in array
     int _numFilled;         // number of slots filled in array
-    void enlargeSize();     // added by student, doubles size of array
-    bool validateHeap(int indexJustChanged); //returns boolean reprsenting if heap is in correct order
+    int _minCapacity = INITIAL_CAPACITY; // automatic shrinking never goes below this
+    double _growthFactor = 2.0;          // array grows by this factor when full
+    bool _shrinkOnDequeue = true;        // whether dequeue may shrink the array
+    double _rebuildThreshold = 1.0;      // enqueueAll rebuilds for batches at least this fraction of the queue
+    ResizeStats _stats;                  // counts of reallocations and bytes copied
+    long _numCopies = 0;                 // elements copied in rather than moved
+    std::pmr::memory_resource* _resource = std::pmr::get_default_resource(); // where the array comes from
+    bool _skipTeardown = false;          // teardown is left to a monotonic arena, see the arena constructor
+    void enlargeSize();     // added by student, grows array by the growth factor
+    void resize(int newCapacity);        // moves elements to a new array of newCapacity slots
+    bool isMoreUrgent(int indexA, int indexB) const; // compares the priorities of two elements
+
+    /* Builds an element from the given arguments, handing allocator-aware
+     * elements the queue's memory resource so they allocate from it. */
+    template <typename... Args>
+    T makeElement(Args&&... args) const {
+        if constexpr (std::uses_allocator<T, std::pmr::polymorphic_allocator<char>>::value) {
+            return T(std::forward<Args>(args)..., std::pmr::polymorphic_allocator<char>(_resource));
+        } else {
+            return buildElement<T>(std::forward<Args>(args)...);
+        }
+    }
+
+    /* Returns the element comparison handed to siftUp and siftDown. */
+    auto elementOrder() const {
+        return [this](const T& a, const T& b) {
+            return _compare(_key(a), _key(b));
+        };
+    }
 
-    void swap(int indexA, int indexB);
+    Compare _compare;       // orders two priorities, true if the first is more urgent
+    KeyFn _key;             // reads the priority of an element
 
     /* Weird C++isms: C++ loves to make copies of things, which is usually a good thing but
      * for the purposes of this assignment requires some C++ knowledge we haven't yet covered.
@@ -114,5 +576,464 @@ private:
      *
      * Curious what this does? Take CS106L!
      */
-    DISALLOW_COPYING_OF(PQHeap);
+    DISALLOW_COPYING_OF(BasicPQHeap);
 };
+
+/*
+ * Synopsis: This is the allocator for the priority queue heap. It initializes the array of elements
+ * and other essential variables for the priority queue heap.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+BasicPQHeap<T, Compare, KeyFn, Arity>::BasicPQHeap(){
+    _numAllocated = INITIAL_CAPACITY;
+    _elements = allocateAlignedArray<T>(_numAllocated, PADDING);
+    _numFilled = 0;
+}
+
+/*
+ * Synopsis: This allocator sizes the array of elements for a known number of elements up front.
+ * A capacity below one still allocates a single slot so that enlargeSize always has something to grow.
+ * The array does not shrink automatically below this capacity.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+BasicPQHeap<T, Compare, KeyFn, Arity>::BasicPQHeap(int capacity){
+    _numAllocated = std::max(capacity, 1);
+    _minCapacity = _numAllocated;
+    _elements = allocateAlignedArray<T>(_numAllocated, PADDING);
+    _numFilled = 0;
+}
+
+/*
+ * Synopsis: This allocator builds the heap out of a vector of elements in one step by handing the
+ * vector's storage to buildFrom.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+BasicPQHeap<T, Compare, KeyFn, Arity>::BasicPQHeap(const Vector<T>& elements){
+    _numAllocated = std::max(elements.size(), 1);
+    _elements = allocateAlignedArray<T>(_numAllocated, PADDING);
+    _numFilled = 0;
+    if (!elements.isEmpty()) {
+        buildFrom(&elements[0], &elements[0] + elements.size());
+    }
+}
+
+/*
+ * Synopsis: This allocator takes the array of elements from a caller-supplied arena. Every later
+ * array comes from the same arena, since resize allocates through _resource. Skipping teardown is
+ * refused for elements that may hold memory from outside the arena, which it would leak.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+BasicPQHeap<T, Compare, KeyFn, Arity>::BasicPQHeap(std::pmr::memory_resource* arena, int capacity, bool skipTeardown){
+    if (skipTeardown && !releasedWithArena<T>) {
+        error("Only elements that are released with the arena can skip teardown");
+    }
+    _resource = arena;
+    _skipTeardown = skipTeardown;
+    _numAllocated = std::max(capacity, 1);
+    _minCapacity = _numAllocated;
+    _elements = allocateAlignedArray<T>(_numAllocated, PADDING, _resource);
+    _numFilled = 0;
+}
+
+/*
+ * Synopsis: This is the deallocator for the priority queue heap. It deletes the leftover array of elements to prevent memory leaks.
+ * A queue built to skip teardown leaves the array alone; its monotonic arena frees it all at once.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+BasicPQHeap<T, Compare, KeyFn, Arity>::~BasicPQHeap() {
+    if (!_skipTeardown) {
+        freeAlignedArray(_elements, _numAllocated, PADDING, _resource);
+    }
+}
+
+/* Function Synopsis:
+ * This helper function compares the elements at two indexes using the key function and comparator
+ * the heap was instantiated with. It returns true if the element at indexA is more urgent than the
+ * element at indexB, and false if it is less urgent or tied.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+bool BasicPQHeap<T, Compare, KeyFn, Arity>::isMoreUrgent(int indexA, int indexB) const {
+    return _compare(_key(_elements[indexA]), _key(_elements[indexB]));
+}
+
+/*
+ * Function Synopsis:
+ * This function adds a copy of its parameter to the end of the priority queue array by handing the
+ * copy to the moving version of enqueue. The copy is made with the queue's memory resource. Nothing is returned.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::enqueue(const T& elem) {
+    _numCopies++;
+    enqueue(makeElement(elem));
+}
+
+/*
+ * Function Synopsis:
+ * This function moves its parameter to the end of the priority queue array. It then calls
+ * siftUp to move it up into place so the heap is in order again. Nothing is returned
+ * since this is a void function, but the array of elements is directly modified.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::enqueue(T&& elem) {
+    if(_numFilled+1 > _numAllocated){//will not be able to add another element without reaching array size
+        enlargeSize();
+    }
+
+    _elements[_numFilled] = std::move(elem);//adds element to last index
+    siftUp<Arity>(_elements, _numFilled, elementOrder());
+    _numFilled++;
+}
+
+/*
+ * Function Synopsis:
+ * This function builds a new element from its parameters and moves it into the queue, so a caller
+ * never has to make a temporary copy of an element just to enqueue it. Nothing is returned.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+template <typename... Args>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::emplace(Args&&... args) {
+    enqueue(makeElement(std::forward<Args>(args)...));
+}
+
+
+/*
+ * Function Synopsis:
+ * This function throws away the current elements and fills the array with the elements in the range
+ * given by its two iterator parameters. If the array is too small, it is replaced once by an array of
+ * exactly the right size instead of being doubled repeatedly. The elements are then put in heap order
+ * with heapify. Nothing is returned.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+template <typename Iterator>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::buildFrom(Iterator first, Iterator last) {
+    int count = int(std::distance(first, last));
+    _numFilled = 0;
+    if (count > _numAllocated) {
+        resize(count);
+    }
+    for (int i = 0; i < count; i++, ++first) {
+        _elements[i] = *first;
+    }
+    _numFilled = count;
+    heapify<Arity>(_elements, _numFilled, elementOrder());
+}
+
+/*
+ * Function Synopsis:
+ * This function appends the elements in the range given by its two iterator parameters, growing the
+ * array once to fit all of them. When the batch is small next to the elements already queued, each new
+ * element is sifted up from where it was appended, which is cheap since most of them stop within a
+ * level or two. Otherwise sifting each one would cost more than heapify's pass over the whole array, so
+ * the array is rebuilt. The rebuild threshold decides which. Nothing is returned.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+template <typename Iterator>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::enqueueAll(Iterator first, Iterator last) {
+    int count = int(std::distance(first, last));
+    if (_numFilled + count > _numAllocated) {
+        resize(std::max(_numFilled + count, grownCapacity(_numAllocated, _growthFactor)));
+    }
+    bool rebuild = count >= _rebuildThreshold * _numFilled;
+    for (int i = 0; i < count; i++, ++first) {
+        _elements[_numFilled] = *first;
+        if (!rebuild) {
+            siftUp<Arity>(_elements, _numFilled, elementOrder());
+        }
+        _numFilled++;
+    }
+    if (rebuild) {
+        heapify<Arity>(_elements, _numFilled, elementOrder());
+    }
+}
+
+/*
+ * Function Synopsis:
+ * This is a helper function for enqueue which grows the array by the growth factor (doubling it by
+ * default) when it is called. The function takes in no parameters and returns no value since it
+ * directly edits the array.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::enlargeSize(){
+    resize(grownCapacity(_numAllocated, _growthFactor));
+}
+
+/*
+ * Function Synopsis:
+ * This helper function replaces the array by a new one with newCapacity slots, which must be at least
+ * the number of elements. The elements are moved over and the move is recorded in the resize counts.
+ * It is used for growing, shrinking and reserving. Nothing is returned.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::resize(int newCapacity){
+    T* newPQ = allocateAlignedArray<T>(newCapacity, PADDING, _resource);//creates new array with room for newCapacity elements
+    for(int i = 0; i<size(); i++){
+        newPQ[i] = std::move(_elements[i]);//transfers all data values from the original array to the new one
+    }
+    freeAlignedArray(_elements, _numAllocated, PADDING, _resource);//deallocates the memory from the previous array
+    _elements = newPQ;
+    _numAllocated = newCapacity;
+    _stats.reallocations++;
+    _stats.bytesCopied += long(size()) * long(sizeof(T));
+}
+
+/*
+ * Function Synopsis:
+ * reserve grows the array once to hold at least its parameter number of elements and remembers that
+ * number as the floor for automatic shrinking. Nothing is returned.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::reserve(int capacity){
+    if(capacity > _numAllocated){
+        resize(capacity);
+    }
+    _minCapacity = std::max(capacity, 1);
+}
+
+/*
+ * Function Synopsis:
+ * shrinkToFit replaces the array by one that holds exactly the current elements (at least one slot)
+ * and resets the floor for automatic shrinking. Nothing is returned.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::shrinkToFit(){
+    _minCapacity = std::min(_minCapacity, INITIAL_CAPACITY);
+    int fitted = std::max(_numFilled, 1);
+    if(fitted < _numAllocated){
+        resize(fitted);
+    }
+}
+
+/*
+ * Function Synopsis:
+ * These functions set the growth factor and whether dequeue shrinks the array. A growth factor of one
+ * or less could never make room for another element, so it is an error.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::setGrowthFactor(double factor){
+    if(!(factor > 1)){
+        error("Growth factor must be greater than 1");
+    }
+    _growthFactor = factor;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::setShrinkOnDequeue(bool enabled){
+    _shrinkOnDequeue = enabled;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::setRebuildThreshold(double fraction){
+    if(!(fraction >= 0)){
+        error("Rebuild threshold must not be negative");
+    }
+    _rebuildThreshold = fraction;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+ResizeStats BasicPQHeap<T, Compare, KeyFn, Arity>::getResizeStats() const {
+    return _stats;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+long BasicPQHeap<T, Compare, KeyFn, Arity>::getCopyCount() const {
+    return _numCopies;
+}
+
+/*
+ * Function Synopsis:
+ * This function returns the top-most (highest priority) element in the priority queue without removing
+ * it from the array. It takes in no parameters.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+T BasicPQHeap<T, Compare, KeyFn, Arity>::peek() const {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    return(_elements[0]);
+}
+
+/*
+ * This function removes and returns the highest priority element from the priority queue. There are
+ * no parameters. The element is moved out of the array instead of copied since its slot is about to be
+ * reused.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+T BasicPQHeap<T, Compare, KeyFn, Arity>::dequeue() {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    T front = std::move(_elements[0]);//element at index 0 is stored
+    _numFilled--;//The priority queue size decrememnts by 1 since the frontmost item is removed and returned
+    if(_numFilled > 0){
+        _elements[0] = std::move(_elements[_numFilled]);//replaces element at first index with last element (its old slot is now empty)
+        siftDown<Arity>(_elements, 0, _numFilled, elementOrder());
+    }
+    if(_shrinkOnDequeue){//gives memory back once the queue has drained well below its capacity
+        int shrunk = shrunkCapacity(_numFilled, _numAllocated, _minCapacity, _growthFactor);
+        if(shrunk < _numAllocated){
+            resize(shrunk);
+        }
+    }
+    return front;
+}
+
+/*
+ * Function Synopsis:
+ * This function moves the frontmost element into the caller's buffer over and over, each time filling
+ * the root with the last element and sifting it down as dequeue does. Since the elements go straight
+ * into the buffer, none is returned by value, and the check for shrinking the array is made once after
+ * all of them are out instead of after each one. The number of elements removed is returned.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+int BasicPQHeap<T, Compare, KeyFn, Arity>::dequeueMany(int k, T* out) {
+    int count = std::max(0, std::min(k, _numFilled));
+    for (int i = 0; i < count; i++) {
+        out[i] = std::move(_elements[0]);
+        _numFilled--;
+        if(_numFilled > 0){
+            _elements[0] = std::move(_elements[_numFilled]);
+            siftDown<Arity>(_elements, 0, _numFilled, elementOrder());
+        }
+    }
+    if(_shrinkOnDequeue){
+        int shrunk = shrunkCapacity(_numFilled, _numAllocated, _minCapacity, _growthFactor);
+        if(shrunk < _numAllocated){
+            resize(shrunk);
+        }
+    }
+    return count;
+}
+
+/*
+ * Function Synopsis:
+ * This function heapsorts the array in its own storage: over and over the front is swapped with the
+ * last element of a shrinking heap, which leaves the elements least urgent first, and one reversal
+ * puts the most urgent first. A pointer to the sorted elements is returned.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+const T* BasicPQHeap<T, Compare, KeyFn, Arity>::sortInPlace() {
+    for (int end = _numFilled - 1; end > 0; end--) {
+        std::swap(_elements[0], _elements[end]);
+        siftDown<Arity>(_elements, 0, end, elementOrder());
+    }
+    std::reverse(_elements, _elements + _numFilled);
+    return _elements;
+}
+
+/*
+ * Function Synopsis:
+ * This function overwrites the frontmost element with its parameter and moves it down into place.
+ * The number of elements never changes, which lets topK use a PQHeap of size k as a bounded heap
+ * without any resizing or extra copies. Nothing is returned.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::replaceFront(const T& elem) {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    _numCopies++;
+    _elements[0] = elem;
+    siftDown<Arity>(_elements, 0, _numFilled, elementOrder());
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::replaceFront(T&& elem) {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    _elements[0] = std::move(elem);
+    siftDown<Arity>(_elements, 0, _numFilled, elementOrder());
+}
+
+/*
+ * Function Synopsis:
+ * This function returns a boolean representing whether or not the array of the priority queue is empty.
+ * There are no parameters and the array is not edited.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+bool BasicPQHeap<T, Compare, KeyFn, Arity>::isEmpty() const {
+    if(size() == 0){
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Function Synopsis:
+ * This function returns an integer representing the size of the array storing the priority queue's elments.
+ * The array is not edited, and there are no parameters.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+int BasicPQHeap<T, Compare, KeyFn, Arity>::size() const {
+    return _numFilled;
+}
+
+/*
+ * Function Synopsis:
+ * This function clears the existing array containing the priority queue's elements. The priority queue
+ * now contains no elements. There are no parameters and nothing is returned.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::clear() {
+    _numFilled = 0;
+}
+
+/*
+ * Function Synopsis:
+ * This function is used for testing purposes, it prints a message then prints out the contents of each
+ * array index of the priority queue. Nothing is returned and the only parameter is the string of the message
+ * to print.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::printDebugInfo(std::string msg) const {
+    std::cout << msg << std::endl;
+    for (int i = 0; i < size(); i++) {
+        std::cout << "[" << i << "] = " << _elements[i] << std::endl;
+    }
+}
+
+/*
+ * Function Synopsis:
+ * This function validates the order of the priority queue's array contents by iterating through each
+ * index and checking that the element is not more urgent than its parent, which covers every
+ * parent-child relationship no matter how many children a node has. An error is thrown containing a
+ * description of the index that breaks the order, otherwise this function runs without stopping or
+ * returning any values if the array is correctly sorted.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicPQHeap<T, Compare, KeyFn, Arity>::validateInternalState() const {
+    if (_numFilled > _numAllocated) error("Too many elements in not enough space!");
+
+    for(int i = 1; i<size(); i++){
+        if(isMoreUrgent(i, getParentIndex(i))){//checks priority
+            error("The priority of index " + integerToString(i) + " has an incorrect priority relationship to its parent.");
+        }
+    }
+}
+
+/*
+ * Function Synopsis:
+ * This helper function calculates the index of the element that is the parent of the
+ * specified child index. If this child has no parent, the sentinel value NONE is returned. The only
+ * parameter is the index of the child in the array.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+int BasicPQHeap<T, Compare, KeyFn, Arity>::getParentIndex(int child) const {
+    if(child == 0){
+        return NONE;
+    }
+    int parentIndex = (child-1)/Arity;
+    return parentIndex;
+}
+
+/**
+ * Priority queue of DataPoints implemented using a binary heap.
+ */
+using PQHeap = BasicPQHeap<DataPoint, std::less<>, DataPointPriority>;
+
+/**
+ * Priority queue of DataPoints implemented using a heap whose nodes have
+ * Arity children, e.g. DAryPQHeap<4> or DAryPQHeap<8>.
+ */
+template <int Arity>
+using DAryPQHeap = BasicPQHeap<DataPoint, std::less<>, DataPointPriority, Arity>;
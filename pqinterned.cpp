@@ -0,0 +1,158 @@
+/*
+ * File Synopsis:
+ * This file implements InternedPQHeap, a priority queue of DataPoints that keeps a name id from a shared
+ * NameTable in each element instead of the name itself. The heap work is done by a BasicPQHeap of
+ * InternedPoints; the functions here translate between names and ids on the way in and out. The tests
+ * are at the bottom of the file, and the memory-per-element comparison with PQHeap is in pqclient.cpp.
+ */
+
+#include "pqinterned.h"
+#include <algorithm>
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+InternedPQHeap::InternedPQHeap(NameTable& names) : _names(names) {}
+
+InternedPQHeap::InternedPQHeap(NameTable& names, int capacity) : _heap(capacity), _names(names) {}
+
+/*
+ * Function Synopsis:
+ * enqueue and emplace intern the name of the new element and add its id and priority to the heap.
+ * A name already in the table is found without allocating. Nothing is returned.
+ */
+void InternedPQHeap::enqueue(const DataPoint& elem) {
+    emplace(elem.name, elem.priority);
+}
+
+void InternedPQHeap::emplace(string_view name, double priority) {
+    _heap.enqueue({ _names.intern(name), priority });
+}
+
+/*
+ * Function Synopsis:
+ * enqueueId adds an element whose name is already interned. The id is checked here so that every id in
+ * the heap can be looked up later without checking again. Nothing is returned.
+ */
+void InternedPQHeap::enqueueId(int nameId, double priority) {
+    if (!_names.isValidId(nameId)) {
+        error("No name with id " + integerToString(nameId));
+    }
+    _heap.enqueue({ nameId, priority });
+}
+
+/*
+ * Function Synopsis:
+ * viewOf pairs the name that an element's id refers to with the element's priority.
+ */
+DataPointView InternedPQHeap::viewOf(const InternedPoint& element) const {
+    return { _names.nameOf(element.nameId), element.priority };
+}
+
+/*
+ * Function Synopsis:
+ * The dequeue and peek functions take the front element from the heap, which calls error() if the queue
+ * is empty, and return it either as a view or as a DataPoint holding a copy of the name.
+ */
+DataPoint InternedPQHeap::dequeue() {
+    return dequeueView().toDataPoint();
+}
+
+DataPointView InternedPQHeap::dequeueView() {
+    return viewOf(_heap.dequeue());
+}
+
+DataPoint InternedPQHeap::peek() const {
+    return peekView().toDataPoint();
+}
+
+DataPointView InternedPQHeap::peekView() const {
+    return viewOf(_heap.peek());
+}
+
+bool InternedPQHeap::isEmpty() const {
+    return _heap.isEmpty();
+}
+
+int InternedPQHeap::size() const {
+    return _heap.size();
+}
+
+void InternedPQHeap::clear() {
+    _heap.clear();
+}
+
+const NameTable& InternedPQHeap::names() const {
+    return _names;
+}
+
+void InternedPQHeap::validateInternalState() const {
+    _heap.validateInternalState();
+    if (!isEmpty() && !_names.isValidId(_heap.peek().nameId)) {
+        error("Front element has a name id that is not in the table");
+    }
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("InternedPQHeap: example from writeup, names come back with their priorities") {
+    NameTable names;
+    InternedPQHeap pq(names);
+    Vector<DataPoint> input = {
+        { "R", 4 }, { "A", 5 }, { "B", 3 }, { "K", 7 }, { "G", 2 },
+        { "V", 9 }, { "T", 1 }, { "O", 8 }, { "S", 6 } };
+
+    for (DataPoint dp : input) {
+        pq.enqueue(dp);
+        pq.validateInternalState();
+    }
+    DataPoint expectedFront = { "T", 1 };
+    EXPECT_EQUAL(pq.peek(), expectedFront);
+    EXPECT_EQUAL(pq.peekView().name, "T");
+
+    Vector<DataPoint> sorted = input;
+    std::sort(sorted.begin(), sorted.end(), [](const DataPoint& a, const DataPoint& b) {
+        return a.priority < b.priority;
+    });
+    for (const DataPoint& expected : sorted) {
+        EXPECT_EQUAL(pq.dequeue(), expected);
+        pq.validateInternalState();
+    }
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peekView());
+}
+
+STUDENT_TEST("InternedPQHeap: queues sharing a table store each repeated name once") {
+    NameTable names;
+    InternedPQHeap jobs(names);
+    InternedPQHeap retries(names);
+    setRandomSeed(12);
+    for (int i = 0; i < 1000; i++) {
+        string host = "worker-" + integerToString(i % 8) + ".cluster.example.com";
+        jobs.emplace(host, randomReal(0, 100));
+        retries.enqueue({ host, randomReal(0, 100) });
+    }
+    EXPECT_EQUAL(names.size(), 8);
+    EXPECT_EQUAL(jobs.size(), 1000);
+
+    int id = names.intern("worker-3.cluster.example.com");
+    jobs.enqueueId(id, -1);
+    EXPECT_ERROR(jobs.enqueueId(names.size(), 0));
+    DataPointView front = jobs.dequeueView();
+    EXPECT_EQUAL(front.name, "worker-3.cluster.example.com");
+    EXPECT_EQUAL(front.priority, -1);
+
+    double last = -1;
+    while (!retries.isEmpty()) {
+        DataPointView view = retries.dequeueView();
+        EXPECT(view.priority >= last);
+        EXPECT(view.name.substr(0, 7) == "worker-");
+        last = view.priority;
+    }
+    jobs.clear();
+    EXPECT(jobs.isEmpty());
+    EXPECT_EQUAL(names.size(), 8);
+}
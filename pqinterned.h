@@ -0,0 +1,172 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "nametable.h"
+#include "pqheap.h"
+
+/**
+ * The element stored by InternedPQHeap: the id of a name in a NameTable in
+ * place of the name itself. It is 16 bytes, against 40 for a DataPoint with
+ * a 64-bit std::string, and moving it never touches the name's characters.
+ */
+struct InternedPoint {
+    int nameId;
+    double priority;
+};
+
+/**
+ * Key function that reads the priority of an InternedPoint.
+ */
+struct InternedPointPriority {
+    double operator()(const InternedPoint& element) const {
+        return element.priority;
+    }
+};
+
+/**
+ * A lightweight, non-owning look at a queued element. The name refers to the
+ * copy held by the NameTable, so it stays valid as long as the table does.
+ */
+struct DataPointView {
+    std::string_view name;
+    double priority;
+
+    /**
+     * Returns an ordinary DataPoint with a copy of this name and priority.
+     */
+    DataPoint toDataPoint() const {
+        return { std::string(name), priority };
+    }
+};
+
+/**
+ * Priority queue of DataPoints that stores each name as an id in a shared
+ * NameTable. When names repeat (job classes, host names), every copy of a
+ * name in the queue costs four bytes instead of a whole std::string, and the
+ * heap moves small fixed-size elements.
+ *
+ * Elements can be taken out either as DataPoints, which copies the name, or
+ * as DataPointViews, which does not.
+ */
+class InternedPQHeap {
+public:
+    /**
+     * Creates a new, empty priority queue that interns names in the given
+     * table. The table may be shared with other queues and must outlive
+     * this one.
+     *
+     * @param names The table in which names are interned.
+     */
+    InternedPQHeap(NameTable& names);
+
+    /**
+     * Creates a new, empty priority queue that interns names in the given
+     * table, with room for capacity elements allocated up front.
+     *
+     * @param names The table in which names are interned.
+     * @param capacity The number of slots to allocate.
+     */
+    InternedPQHeap(NameTable& names, int capacity);
+
+    /**
+     * Adds a new element into the queue, interning its name. This operation
+     * runs in time O(log n) plus the expected O(length) time to hash the name.
+     *
+     * @param element The element to add.
+     */
+    void enqueue(const DataPoint& element);
+
+    /**
+     * Adds a new element with the given name and priority into the queue
+     * without building a DataPoint first.
+     * This operation runs in the same time as enqueue.
+     *
+     * @param name The name of the new element.
+     * @param priority The priority of the new element.
+     */
+    void emplace(std::string_view name, double priority);
+
+    /**
+     * Adds a new element whose name already has the given id in this queue's
+     * table, skipping the hash lookup. If the id is not in the table, this
+     * function calls error(). This operation runs in time O(log n).
+     *
+     * @param nameId The id of the name of the new element.
+     * @param priority The priority of the new element.
+     */
+    void enqueueId(int nameId, double priority);
+
+    /**
+     * Removes and returns the frontmost element as a DataPoint with its own
+     * copy of the name. If the queue is empty, this function calls error().
+     * This operation runs in time O(log n).
+     *
+     * @return The frontmost element, which is removed from the queue.
+     */
+    DataPoint dequeue();
+
+    /**
+     * Removes the frontmost element and returns a view of it that does not
+     * copy the name. If the queue is empty, this function calls error().
+     * This operation runs in time O(log n).
+     *
+     * @return A view of the frontmost element, which is removed from the queue.
+     */
+    DataPointView dequeueView();
+
+    /**
+     * Returns, but does not remove, the frontmost element as a DataPoint.
+     * If the queue is empty, this function calls error().
+     * This operation runs in time O(1) plus the time to copy the name.
+     *
+     * @return The frontmost element.
+     */
+    DataPoint peek() const;
+
+    /**
+     * Returns, but does not remove, a view of the frontmost element.
+     * If the queue is empty, this function calls error().
+     * This operation runs in time O(1).
+     *
+     * @return A view of the frontmost element.
+     */
+    DataPointView peekView() const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Removes all elements from the priority queue. Names stay in the table.
+     */
+    void clear();
+
+    /**
+     * Returns the table in which this queue interns its names.
+     */
+    const NameTable& names() const;
+
+    /*
+     * This function exits purely for testing purposes. It verifies that the
+     * heap is in order and that the frontmost element names an entry in the
+     * table (enqueue never stores an id the table did not hand out).
+     * If a problem is detected, this function calls error().
+     */
+    void validateInternalState() const;
+
+private:
+    BasicPQHeap<InternedPoint, std::less<>, InternedPointPriority> _heap; // ids and priorities, in heap order
+    NameTable& _names;                                                  // shared table the ids refer to
+
+    DataPointView viewOf(const InternedPoint& element) const; // looks up the name of an element
+
+    DISALLOW_COPYING_OF(InternedPQHeap);
+};
@@ -0,0 +1,147 @@
+/*
+ * File Synopsis:
+ * The multi-queue is a relaxed priority queue for many threads: several PQHeaps behind their own locks,
+ * where dequeue takes the better front of two sub-queues chosen at random. It is a class template, so
+ * its implementation lives in pqmultiqueue.h. This file instantiates the DataPoint queue (MultiQueue)
+ * and contains its tests; the rank error and throughput trials are in pqclient.cpp.
+ */
+
+#include "pqmultiqueue.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include "datapoint.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/* The DataPoint queue is instantiated here so that every member function is compiled
+ * even if no test happens to call it.
+ */
+template class BasicMultiQueue<DataPoint, std::less<>, DataPointPriority>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("MultiQueue: a single sub-queue is exact, validate each step") {
+    MultiQueue pq(1, 1);
+    Vector<DataPoint> input = {
+        { "R", 4 }, { "A", 5 }, { "B", 3 }, { "K", 7 }, { "G", 2 },
+        { "V", 9 }, { "T", 1 }, { "O", 8 }, { "S", 6 } };
+
+    pq.validateInternalState();
+    for (DataPoint dp : input) {
+        pq.enqueue(dp);
+        pq.validateInternalState();
+    }
+    EXPECT_EQUAL(pq.size(), 9);
+    for (int expected = 1; expected <= 9; expected++) {
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+        pq.validateInternalState();
+    }
+    DataPoint unused;
+    EXPECT(!pq.tryDequeue(unused));
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(MultiQueue(0));
+}
+
+STUDENT_TEST("MultiQueue: every element comes out once, with small rank error") {
+    MultiQueue pq(4);
+    Vector<double> remaining;  // priorities still queued, kept sorted
+    for (int i = 0; i < 2000; i++) {
+        remaining.add(i);
+    }
+    Vector<double> shuffled = remaining;
+    setRandomSeed(18);
+    for (int i = shuffled.size() - 1; i > 0; i--) {
+        swap(shuffled[i], shuffled[randomInteger(0, i)]);
+    }
+    for (double priority : shuffled) {
+        pq.enqueue({ "", priority });
+    }
+    pq.validateInternalState();
+
+    long totalRank = 0;
+    while (!pq.isEmpty()) {
+        double priority = pq.dequeue().priority;
+        int rank = int(lower_bound(remaining.begin(), remaining.end(), priority) - remaining.begin());
+        EXPECT(rank < remaining.size() && remaining[rank] == priority);
+        totalRank += rank;
+        remaining.remove(rank);
+    }
+    EXPECT(remaining.isEmpty());
+    EXPECT(totalRank < 2000L * 2 * pq.numQueues());  // mean rank error within a small multiple of the sub-queues
+    pq.validateInternalState();
+}
+
+STUDENT_TEST("BasicMultiQueue: largest first, clear") {
+    BasicMultiQueue<int, greater<>> pq(1, 1);
+    for (int i = 0; i < 100; i++) {
+        pq.enqueue(i);
+    }
+    EXPECT_EQUAL(pq.dequeue(), 99);
+    EXPECT_EQUAL(pq.dequeue(), 98);
+    pq.clear();
+    EXPECT(pq.isEmpty());
+    pq.validateInternalState();
+}
+
+STUDENT_TEST("BasicMultiQueue: the least urgent possible priority is not mistaken for an empty sub-queue") {
+    BasicMultiQueue<uint64_t> largest(1, 2);
+    largest.enqueue(UINT64_MAX);
+    largest.validateInternalState();
+    BasicMultiQueue<int, greater<>> smallest(1, 2);
+    smallest.enqueue(INT_MIN);
+    smallest.enqueue(INT_MIN + 1);
+    smallest.validateInternalState();
+
+    EXPECT_EQUAL(largest.dequeue(), UINT64_MAX);
+    EXPECT_EQUAL(smallest.size(), 2);
+    int first = smallest.dequeue();
+    int second = smallest.dequeue();
+    EXPECT(min(first, second) == INT_MIN && max(first, second) == INT_MIN + 1);
+    smallest.validateInternalState();
+}
+
+STUDENT_TEST("MultiQueue: mixed producers and consumers lose and duplicate nothing") {
+    const int numThreads = 4;
+    const int perThread = 5000;
+    MultiQueue pq(numThreads);
+    Vector<Vector<double>> taken(numThreads);
+    vector<thread> workers;
+    for (int t = 0; t < numThreads; t++) {
+        workers.push_back(thread([&pq, &taken, t]() {
+            DataPoint front;
+            for (int i = 0; i < perThread; i++) {
+                pq.emplace("", double(i * numThreads + t));
+                if (i % 2 == 1 && pq.tryDequeue(front)) {
+                    taken[t].add(front.priority);
+                }
+            }
+        }));
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    pq.validateInternalState();
+
+    Vector<double> all;
+    for (const Vector<double>& fromThread : taken) {
+        for (double priority : fromThread) {
+            all.add(priority);
+        }
+    }
+    DataPoint front;
+    while (pq.tryDequeue(front)) {
+        all.add(front.priority);
+    }
+    sort(all.begin(), all.end());
+    EXPECT_EQUAL(all.size(), numThreads * perThread);
+    for (int i = 0; i < all.size(); i++) {
+        EXPECT_EQUAL(all[i], i);
+    }
+}
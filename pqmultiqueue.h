@@ -0,0 +1,341 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "strlib.h"
+#include "pqheap.h"
+#include "pqradix.h"
+
+/**
+ * Relaxed priority queue of elements of type T for many threads, made of
+ * several independent BasicPQHeaps (the MultiQueue of Rihani, Sanders and
+ * Dementiev). It gives up strict order for throughput: dequeue returns an
+ * element close to the front, not always the front itself.
+ *
+ * There are perThread sub-queues for every thread expected to use the queue
+ * (two by default), each behind its own mutex.
+ * - enqueue picks a sub-queue at random and adds to it, picking another if
+ *   its lock is taken, so a thread never waits for one.
+ * - dequeue picks two sub-queues at random, compares the priorities at their
+ *   fronts, and dequeues from the more urgent one.
+ * The front priority of each sub-queue is kept in an atomic beside it, so
+ * the comparison takes no lock. With more sub-queues than threads, two
+ * threads rarely want the same one, and the element returned is on average
+ * among the first few dozen of the whole queue (its rank error); the tests and
+ * the trial in pqclient.cpp measure that distribution.
+ *
+ * Priorities are compared through radixKey, so KeyFn must give an integer
+ * type or double, and Compare must be std::less<> or std::greater<>, as for
+ * BasicStablePQHeap. There is no peek, since the front is not defined.
+ */
+template <typename T, typename Compare = std::less<>, typename KeyFn = IdentityKey>
+class BasicMultiQueue {
+    static_assert(std::is_same<Compare, std::less<>>::value || std::is_same<Compare, std::greater<>>::value,
+                  "A multi-queue orders by std::less<> or std::greater<>");
+
+public:
+    /**
+     * Creates a new, empty priority queue of perThread * numThreads
+     * sub-queues. If either is less than one, this function calls error().
+     *
+     * @param numThreads The number of threads expected to share the queue.
+     * @param perThread The number of sub-queues for each thread.
+     */
+    BasicMultiQueue(int numThreads, int perThread = 2);
+
+    /**
+     * Cleans up all memory allocated by this priority queue.
+     */
+    ~BasicMultiQueue();
+
+    /**
+     * Adds a new element into a randomly chosen sub-queue. This operation
+     * runs in time O(log n) and never waits for a lock unless every
+     * sub-queue is locked.
+     *
+     * @param element The element to add.
+     */
+    void enqueue(const T& element);
+    void enqueue(T&& element);
+
+    /**
+     * Adds a new element into the queue, constructing it from the given
+     * arguments.
+     *
+     * @param args The arguments used to brace-initialize the element.
+     */
+    template <typename... Args>
+    void emplace(Args&&... args);
+
+    /**
+     * Removes and returns an element near the front of this priority queue:
+     * the front of the more urgent of two randomly chosen sub-queues.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(log n).
+     *
+     * @return The element removed from the queue.
+     */
+    T dequeue();
+
+    /**
+     * Removes an element near the front and moves it into front, or returns
+     * false and leaves front alone if every sub-queue was found empty.
+     *
+     * @param front Receives the element removed.
+     * @return Whether an element was dequeued.
+     */
+    bool tryDequeue(T& front);
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue. While other
+     * threads are using the queue, this is only a snapshot.
+     */
+    int size() const;
+
+    /**
+     * Returns the number of sub-queues.
+     */
+    int numQueues() const;
+
+    /**
+     * Removes all elements from the priority queue.
+     */
+    void clear();
+
+    /*
+     * This function exists purely for testing purposes. It prints every
+     * sub-queue. No other thread may use the queue meanwhile.
+     */
+    void printDebugInfo(std::string msg) const;
+
+    /*
+     * This function exits purely for testing purposes. It verifies that
+     * every sub-queue is a valid heap whose cached front priority is right
+     * and that their sizes add up to size(). No other thread may use the
+     * queue meanwhile. If a problem is detected, this function calls error().
+     */
+    void validateInternalState() const;
+
+private:
+    static constexpr uint64_t NO_FRONT = UINT64_MAX; // cached front of an empty sub-queue
+    static constexpr int SAMPLES_BEFORE_SCAN = 8;    // empty samples before dequeue checks every sub-queue
+
+    /* A sub-queue, aligned to a cache line so that threads working on
+     * neighboring sub-queues do not contend for the same line. */
+    struct alignas(64) SubQueue {
+        std::mutex lock;
+        std::atomic<uint64_t> front{NO_FRONT};   // orderedPriority of the heap's front, or NO_FRONT
+        BasicPQHeap<T, Compare, KeyFn> heap;
+    };
+
+    SubQueue* _queues;      // the sub-queues
+    int _numQueues;         // number of sub-queues
+    std::atomic<int> _numFilled; // elements in all the sub-queues together
+    KeyFn _key;             // reads the priority of an element
+
+    /* The priority mapped so that more urgent is smaller: radixKey for
+     * smallest first, its complement for largest first. The least urgent
+     * value is lowered by one so that no element is ever cached as NO_FRONT;
+     * it then ties with the value before it, which only affects the choice
+     * between two sampled sub-queues. */
+    uint64_t orderedPriority(const T& element) const {
+        uint64_t radix = radixKey(_key(element));
+        uint64_t ordered = std::is_same<Compare, std::greater<>>::value ? ~radix : radix;
+        return std::min(ordered, NO_FRONT - 1);
+    }
+
+    int randomQueue();                    // a sub-queue index drawn by the calling thread
+    void updateFront(SubQueue& queue);    // recaches the front, with the queue locked
+    bool dequeueFrom(SubQueue& queue, T& front); // with the queue locked
+
+    DISALLOW_COPYING_OF(BasicMultiQueue);
+};
+
+template <typename T, typename Compare, typename KeyFn>
+BasicMultiQueue<T, Compare, KeyFn>::BasicMultiQueue(int numThreads, int perThread) {
+    if (numThreads < 1 || perThread < 1) {
+        error("A multi-queue needs at least one thread and one sub-queue per thread");
+    }
+    _numQueues = numThreads * perThread;
+    _queues = new SubQueue[_numQueues];
+    _numFilled = 0;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+BasicMultiQueue<T, Compare, KeyFn>::~BasicMultiQueue() {
+    delete[] _queues;
+}
+
+/*
+ * Private helper that draws a sub-queue index from a generator belonging to
+ * the calling thread, so that threads never share random state.
+ */
+template <typename T, typename Compare, typename KeyFn>
+int BasicMultiQueue<T, Compare, KeyFn>::randomQueue() {
+    thread_local std::minstd_rand generator(unsigned(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1);
+    return int(generator() % unsigned(_numQueues));
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicMultiQueue<T, Compare, KeyFn>::updateFront(SubQueue& queue) {
+    queue.front.store(queue.heap.isEmpty() ? NO_FRONT : orderedPriority(queue.heap.peek()),
+                      std::memory_order_relaxed);
+}
+
+template <typename T, typename Compare, typename KeyFn>
+bool BasicMultiQueue<T, Compare, KeyFn>::dequeueFrom(SubQueue& queue, T& front) {
+    if (queue.heap.isEmpty()) {
+        return false;
+    }
+    front = queue.heap.dequeue();
+    updateFront(queue);
+    _numFilled--;
+    return true;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicMultiQueue<T, Compare, KeyFn>::enqueue(const T& element) {
+    enqueue(T(element));
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicMultiQueue<T, Compare, KeyFn>::enqueue(T&& element) {
+    while (true) {
+        SubQueue& queue = _queues[randomQueue()];
+        if (queue.lock.try_lock()) {
+            queue.heap.enqueue(std::move(element));
+            updateFront(queue);
+            _numFilled++;
+            queue.lock.unlock();
+            return;
+        }
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn>
+template <typename... Args>
+void BasicMultiQueue<T, Compare, KeyFn>::emplace(Args&&... args) {
+    enqueue(buildElement<T>(std::forward<Args>(args)...));
+}
+
+template <typename T, typename Compare, typename KeyFn>
+T BasicMultiQueue<T, Compare, KeyFn>::dequeue() {
+    T front;
+    if (!tryDequeue(front)) {
+        error("PQueue is empty!");
+    }
+    return front;
+}
+
+/*
+ * Two sub-queues are sampled and the one whose cached front is more urgent is
+ * locked without waiting; a busy lock or a front that another thread took in
+ * the meantime just means sampling again. Repeated samples that find only
+ * empty sub-queues fall back to locking each sub-queue in turn, so false is
+ * returned only if every one of them was empty when it was looked at.
+ */
+template <typename T, typename Compare, typename KeyFn>
+bool BasicMultiQueue<T, Compare, KeyFn>::tryDequeue(T& front) {
+    int emptySamples = 0;
+    while (emptySamples < SAMPLES_BEFORE_SCAN) {
+        if (_numFilled.load(std::memory_order_relaxed) == 0) {
+            break;
+        }
+        SubQueue& first = _queues[randomQueue()];
+        SubQueue& second = _queues[randomQueue()];
+        SubQueue& better = second.front.load(std::memory_order_relaxed) < first.front.load(std::memory_order_relaxed)
+                ? second : first;
+        if (better.front.load(std::memory_order_relaxed) == NO_FRONT) {
+            emptySamples++;
+            continue;
+        }
+        if (better.lock.try_lock()) {
+            bool found = dequeueFrom(better, front);
+            better.lock.unlock();
+            if (found) {
+                return true;
+            }
+        }
+    }
+    for (int i = 0; i < _numQueues; i++) {
+        std::lock_guard<std::mutex> guard(_queues[i].lock);
+        if (dequeueFrom(_queues[i], front)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+bool BasicMultiQueue<T, Compare, KeyFn>::isEmpty() const {
+    return size() == 0;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+int BasicMultiQueue<T, Compare, KeyFn>::size() const {
+    return _numFilled.load();
+}
+
+template <typename T, typename Compare, typename KeyFn>
+int BasicMultiQueue<T, Compare, KeyFn>::numQueues() const {
+    return _numQueues;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicMultiQueue<T, Compare, KeyFn>::clear() {
+    for (int i = 0; i < _numQueues; i++) {
+        std::lock_guard<std::mutex> guard(_queues[i].lock);
+        _numFilled -= _queues[i].heap.size();
+        _queues[i].heap.clear();
+        updateFront(_queues[i]);
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicMultiQueue<T, Compare, KeyFn>::printDebugInfo(std::string msg) const {
+    std::cout << msg << std::endl;
+    for (int i = 0; i < _numQueues; i++) {
+        _queues[i].heap.printDebugInfo("sub-queue " + integerToString(i));
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicMultiQueue<T, Compare, KeyFn>::validateInternalState() const {
+    int count = 0;
+    for (int i = 0; i < _numQueues; i++) {
+        const SubQueue& queue = _queues[i];
+        queue.heap.validateInternalState();
+        if (!queue.heap.isEmpty() && queue.front.load() == NO_FRONT) {
+            error("Sub-queue " + integerToString(i) + " has elements but is cached as empty.");
+        }
+        uint64_t expected = queue.heap.isEmpty() ? NO_FRONT : orderedPriority(queue.heap.peek());
+        if (queue.front.load() != expected) {
+            error("The cached front of sub-queue " + integerToString(i) + " is out of date.");
+        }
+        count += queue.heap.size();
+    }
+    if (count != _numFilled.load()) error("The sub-queues hold a different number of elements than counted.");
+}
+
+/**
+ * Relaxed priority queue of DataPoints, smallest priority first.
+ */
+using MultiQueue = BasicMultiQueue<DataPoint, std::less<>, DataPointPriority>;
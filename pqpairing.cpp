@@ -0,0 +1,109 @@
+/*
+ * File Synopsis:
+ * The pairing heap keeps its elements in a tree with no shape rule, melding trees in constant time, which
+ * makes enqueue and lowering a priority cheap. It is a class template, so its implementation lives in
+ * pqpairing.h. This file instantiates the DataPoint queue (PairingPQHeap) and contains its tests; the time
+ * trials against the other engines are in pqclient.cpp.
+ */
+
+#include "pqpairing.h"
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include "datapoint.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/* The DataPoint queue is instantiated here so that every member function is compiled
+ * even if no test happens to call it.
+ */
+template class BasicPairingPQHeap<DataPoint, std::less<>, DataPointPriority>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("PairingPQHeap: example from writeup, validate each step") {
+    PairingPQHeap pq;
+    Vector<DataPoint> input = {
+        { "R", 4 }, { "A", 5 }, { "B", 3 }, { "K", 7 }, { "G", 2 },
+        { "V", 9 }, { "T", 1 }, { "O", 8 }, { "S", 6 } };
+
+    pq.validateInternalState();
+    for (DataPoint dp : input) {
+        pq.enqueue(dp);
+        pq.validateInternalState();
+    }
+    DataPoint expectedFront = { "T", 1 };
+    EXPECT_EQUAL(pq.peek(), expectedFront);
+    for (int expected = 1; expected <= 9; expected++) {
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+        pq.validateInternalState();
+    }
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peek());
+}
+
+STUDENT_TEST("PairingPQHeap: lowering, raising and removing through handles") {
+    PairingPQHeap pq;
+    Vector<int> handles;
+    for (int i = 0; i < 20; i++) {
+        handles.add(pq.emplace("job " + integerToString(i), 100.0 + i));
+    }
+    pq.dequeue();                           // pairs up the root's children so the tree has depth
+    pq.changePriority(handles[17], 1);      // cut and meld with the root
+    pq.validateInternalState();
+    EXPECT_EQUAL(pq.peek().name, "job 17");
+    pq.changePriority(handles[17], 500);    // the root becomes the least urgent
+    pq.validateInternalState();
+    pq.changePriority(handles[5], 50);
+    DataPoint removed = pq.remove(handles[9]);
+    EXPECT_EQUAL(removed.priority, 109);
+    EXPECT(!pq.contains(handles[9]));
+    EXPECT_ERROR(pq.changePriority(handles[9], 0));
+    pq.validateInternalState();
+
+    EXPECT_EQUAL(pq.dequeue().name, "job 5");
+    double last = 0;
+    while (pq.size() > 1) {
+        double priority = pq.dequeue().priority;
+        EXPECT(priority >= last);
+        last = priority;
+    }
+    EXPECT_EQUAL(pq.get(handles[17]).priority, 500);
+    pq.clear();
+    EXPECT(!pq.contains(handles[17]));
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("BasicPairingPQHeap: random operations, growth and greater-first order") {
+    BasicPairingPQHeap<int, greater<>> pq;
+    Vector<int> handles;
+    setRandomSeed(99);
+    for (int step = 0; step < 3000; step++) {
+        int choice = randomInteger(0, 9);
+        if (handles.isEmpty() || choice < 4) {
+            handles.add(pq.enqueue(randomInteger(-1000, 1000)));
+        } else if (choice < 7) {
+            pq.changePriority(handles[randomInteger(0, handles.size() - 1)], randomInteger(-1000, 1000));
+        } else if (choice < 9) {
+            int i = randomInteger(0, handles.size() - 1);
+            pq.remove(handles[i]);
+            handles.remove(i);
+        } else {
+            int largest = pq.get(handles[0]);
+            for (int handle : handles) {
+                largest = max(largest, pq.get(handle));
+            }
+            EXPECT_EQUAL(pq.peek(), largest);
+            for (int i = 0; i < handles.size(); i++) {
+                if (pq.get(handles[i]) == largest) {
+                    pq.remove(handles[i]);
+                    handles.remove(i);
+                    break;
+                }
+            }
+        }
+        EXPECT_EQUAL(pq.size(), handles.size());
+        pq.validateInternalState();
+    }
+}
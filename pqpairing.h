@@ -0,0 +1,532 @@
+#pragma once
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "strlib.h"
+#include "vector.h"
+#include "pqheap.h"
+
+/**
+ * Priority queue of elements of type T implemented as a pairing heap: a
+ * tree in which every node is at least as urgent as its children, with no
+ * shape rule at all. Two trees are melded in O(1) by making the less urgent
+ * root the first child of the other, so enqueue and lowering a priority are
+ * O(1); dequeue melds the children of the old root in two passes (pairs left
+ * to right, then the results right to left), which is O(log n) amortized.
+ * It wins over a binary heap when priorities are lowered far more often than
+ * elements are dequeued, as in Dijkstra's algorithm on dense graphs.
+ *
+ * Like BasicAddressablePQHeap, enqueue returns a handle that names the element
+ * until it leaves the queue, and changePriority and remove take a handle.
+ *
+ * Nodes live in one array indexed by handle and link to each other by index
+ * (first child, next sibling, and the node before them: the parent for a
+ * first child, else the previous sibling), so the heap allocates only when
+ * the array grows. The template parameters mean the same as for BasicPQHeap.
+ */
+template <typename T, typename Compare = std::less<>, typename KeyFn = IdentityKey>
+class BasicPairingPQHeap {
+public:
+    /* The type of priority that KeyFn reads from an element. */
+    using Key = std::decay_t<decltype(std::declval<KeyFn>()(std::declval<const T&>()))>;
+
+    /* Names a queued element; returned by enqueue. */
+    using Handle = int;
+
+    /**
+     * Creates a new, empty priority queue.
+     */
+    BasicPairingPQHeap();
+
+    /**
+     * Creates a new, empty priority queue with room for capacity elements
+     * allocated up front.
+     *
+     * @param capacity The number of nodes to allocate.
+     */
+    BasicPairingPQHeap(int capacity);
+
+    /**
+     * Cleans up all memory allocated by this priority queue.
+     */
+    ~BasicPairingPQHeap();
+
+    /**
+     * Adds a new element into the queue and returns the handle that names it.
+     * This operation runs in time O(1).
+     *
+     * @param element The element to add.
+     * @return The handle of the new element.
+     */
+    Handle enqueue(const T& element);
+    Handle enqueue(T&& element);
+
+    /**
+     * Adds a new element into the queue, constructing it from the given
+     * arguments, and returns its handle. This operation runs in time O(1).
+     *
+     * @param args The arguments used to brace-initialize the element.
+     * @return The handle of the new element.
+     */
+    template <typename... Args>
+    Handle emplace(Args&&... args);
+
+    /**
+     * Removes and returns the element that is frontmost in this priority queue.
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in amortized time O(log n).
+     *
+     * @return The frontmost element, which is removed from queue.
+     */
+    T dequeue();
+
+    /**
+     * Removes and returns the element named by the given handle. If the handle
+     * does not name a queued element, this function calls error().
+     *
+     * This operation runs in amortized time O(log n).
+     *
+     * @param handle The handle of the element to remove.
+     * @return The removed element.
+     */
+    T remove(Handle handle);
+
+    /**
+     * Changes the priority of the element named by the given handle and writes
+     * it into the element. Making an element more urgent is one cut and one
+     * meld, which is O(1) apart from the work it leaves for later dequeues;
+     * making it less urgent costs as much as a remove and an enqueue, and the
+     * element keeps its handle. If the handle does not name a queued element,
+     * this function calls error().
+     *
+     * @param handle The handle of the element to change.
+     * @param priority The new priority of the element.
+     */
+    void changePriority(Handle handle, const Key& priority);
+
+    /**
+     * Returns the element named by the given handle without removing it. If
+     * the handle does not name a queued element, this function calls error().
+     */
+    const T& get(Handle handle) const;
+
+    /**
+     * Returns whether the given handle names an element that is in the queue.
+     */
+    bool contains(Handle handle) const;
+
+    /**
+     * Returns, but does not remove, the element that is frontmost.
+     * If the priority queue is empty, this function calls error().
+     * This operation runs in time O(1).
+     */
+    T peek() const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Removes all elements from the priority queue. Every handle becomes
+     * invalid. This operation runs in time O(capacity).
+     */
+    void clear();
+
+    /*
+     * This function exists purely for testing purposes. It prints every
+     * queued node with its first child and next sibling.
+     */
+    void printDebugInfo(std::string msg) const;
+
+    /*
+     * This function exits purely for testing purposes. It walks the tree from
+     * the root and verifies that no child is more urgent than its parent, that
+     * every link back to a node matches the link to it, that every entry's
+     * priority matches its element, and that every queued node is reached.
+     * If a problem is detected, this function calls error().
+     */
+    void validateInternalState() const;
+
+private:
+    static constexpr int INITIAL_CAPACITY = 10;
+    static constexpr int NONE = -1; // an absent link
+    static constexpr int FREE = -2; // the before link of a node that is not in the queue
+
+    /* One node of the tree, at the index of its handle. */
+    struct Node {
+        Key key;
+        int child = NONE;       // first (leftmost) child
+        int sibling = NONE;     // next sibling to the right
+        int before = FREE;      // parent if this is a first child, else previous sibling; NONE for the root
+    };
+
+    Node* _nodes;           // nodes, indexed by handle
+    T* _payloads;           // elements, indexed by handle
+    int* _freeHandles;      // stack of unused handles, _numAllocated - _numFilled of them
+    int _root;              // handle of the frontmost element, or NONE
+    int _numAllocated;      // number of nodes allocated
+    int _numFilled;         // number of elements in the queue
+
+    Compare _compare;       // orders two priorities, true if the first is more urgent
+    KeyFn _key;             // reads and writes the priority of an element
+
+    void allocateArrays(int capacity);
+    void freeArrays();
+    void enlargeSize();
+    void checkHandle(Handle handle) const;
+    int meld(int a, int b);         // links two roots, returns the new root
+    int mergePairs(int first);      // melds a list of siblings into one tree, returns its root
+    void cut(int node);             // detaches a non-root node (and its subtree) from the tree
+    void detach(int node);          // takes a node out of the tree, its children staying queued
+
+    DISALLOW_COPYING_OF(BasicPairingPQHeap);
+};
+
+template <typename T, typename Compare, typename KeyFn>
+BasicPairingPQHeap<T, Compare, KeyFn>::BasicPairingPQHeap() {
+    allocateArrays(INITIAL_CAPACITY);
+}
+
+template <typename T, typename Compare, typename KeyFn>
+BasicPairingPQHeap<T, Compare, KeyFn>::BasicPairingPQHeap(int capacity) {
+    allocateArrays(std::max(capacity, 1));
+}
+
+template <typename T, typename Compare, typename KeyFn>
+BasicPairingPQHeap<T, Compare, KeyFn>::~BasicPairingPQHeap() {
+    freeArrays();
+}
+
+/*
+ * Private helper that allocates the node, payload and free handle arrays
+ * with room for capacity elements, all of them free.
+ */
+template <typename T, typename Compare, typename KeyFn>
+void BasicPairingPQHeap<T, Compare, KeyFn>::allocateArrays(int capacity) {
+    _numAllocated = capacity;
+    _numFilled = 0;
+    _root = NONE;
+    _nodes = new Node[capacity]();
+    _payloads = new T[capacity]();
+    _freeHandles = new int[capacity];
+    for (int i = 0; i < capacity; i++) {
+        _freeHandles[i] = capacity - 1 - i;
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicPairingPQHeap<T, Compare, KeyFn>::freeArrays() {
+    delete[] _nodes;
+    delete[] _payloads;
+    delete[] _freeHandles;
+}
+
+/*
+ * Private helper that doubles every array. It is only called when the queue
+ * is full, so every old handle keeps its number and the links stay valid.
+ */
+template <typename T, typename Compare, typename KeyFn>
+void BasicPairingPQHeap<T, Compare, KeyFn>::enlargeSize() {
+    int newAllocated = _numAllocated * 2;
+    Node* newNodes = new Node[newAllocated]();
+    T* newPayloads = new T[newAllocated]();
+    int* newFreeHandles = new int[newAllocated];
+    for (int i = 0; i < _numAllocated; i++) {
+        newNodes[i] = _nodes[i];
+        newPayloads[i] = std::move(_payloads[i]);
+    }
+    for (int i = 0; i < newAllocated - _numAllocated; i++) {
+        newFreeHandles[i] = newAllocated - 1 - i;
+    }
+    int root = _root;
+    int filled = _numFilled;
+    freeArrays();
+    _nodes = newNodes;
+    _payloads = newPayloads;
+    _freeHandles = newFreeHandles;
+    _numAllocated = newAllocated;
+    _root = root;
+    _numFilled = filled;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicPairingPQHeap<T, Compare, KeyFn>::checkHandle(Handle handle) const {
+    if (!contains(handle)) {
+        error("Handle " + integerToString(handle) + " does not name an element in the queue");
+    }
+}
+
+/*
+ * Private helper that links two roots (nodes with no siblings): the less urgent
+ * one becomes the first child of the other, which is returned. On a tie the
+ * first root stays on top. The caller sets the before link of the result.
+ */
+template <typename T, typename Compare, typename KeyFn>
+int BasicPairingPQHeap<T, Compare, KeyFn>::meld(int a, int b) {
+    if (a == NONE) return b;
+    if (b == NONE) return a;
+    if (_compare(_nodes[b].key, _nodes[a].key)) {
+        std::swap(a, b);
+    }
+    _nodes[b].sibling = _nodes[a].child;
+    if (_nodes[a].child != NONE) {
+        _nodes[_nodes[a].child].before = b;
+    }
+    _nodes[b].before = a;
+    _nodes[a].child = b;
+    return a;
+}
+
+/*
+ * Private helper, the two-pass pairing. The first pass melds the siblings in
+ * pairs from left to right and threads the results into a list in reverse
+ * through their sibling links; the second pass melds that list into one tree
+ * from right to left. No extra memory is needed.
+ */
+template <typename T, typename Compare, typename KeyFn>
+int BasicPairingPQHeap<T, Compare, KeyFn>::mergePairs(int first) {
+    if (first == NONE) {
+        return NONE;
+    }
+    int reversed = NONE;
+    while (first != NONE) {
+        int a = first;
+        int b = _nodes[a].sibling;
+        if (b == NONE) {
+            first = NONE;
+        } else {
+            first = _nodes[b].sibling;
+            _nodes[a].sibling = NONE;
+            _nodes[b].sibling = NONE;
+            a = meld(a, b);
+        }
+        _nodes[a].sibling = reversed;
+        reversed = a;
+    }
+    int result = reversed;
+    reversed = _nodes[result].sibling;
+    _nodes[result].sibling = NONE;
+    while (reversed != NONE) {
+        int next = _nodes[reversed].sibling;
+        _nodes[reversed].sibling = NONE;
+        result = meld(result, reversed);
+        reversed = next;
+    }
+    _nodes[result].before = NONE;
+    return result;
+}
+
+/*
+ * Private helper that unlinks a node other than the root from its parent or
+ * previous sibling, leaving it the root of its own subtree.
+ */
+template <typename T, typename Compare, typename KeyFn>
+void BasicPairingPQHeap<T, Compare, KeyFn>::cut(int node) {
+    int before = _nodes[node].before;
+    int after = _nodes[node].sibling;
+    if (_nodes[before].child == node) {
+        _nodes[before].child = after;
+    } else {
+        _nodes[before].sibling = after;
+    }
+    if (after != NONE) {
+        _nodes[after].before = before;
+    }
+    _nodes[node].sibling = NONE;
+    _nodes[node].before = NONE;
+}
+
+/*
+ * Private helper that takes a node out of the tree: its children are paired
+ * into one tree, which takes its place (at the root) or is melded with the
+ * root. The node is left with no links.
+ */
+template <typename T, typename Compare, typename KeyFn>
+void BasicPairingPQHeap<T, Compare, KeyFn>::detach(int node) {
+    int children = mergePairs(_nodes[node].child);
+    _nodes[node].child = NONE;
+    if (node == _root) {
+        _root = children;
+    } else {
+        cut(node);
+        _root = meld(_root, children);
+        _nodes[_root].before = NONE;
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn>
+typename BasicPairingPQHeap<T, Compare, KeyFn>::Handle
+BasicPairingPQHeap<T, Compare, KeyFn>::enqueue(const T& element) {
+    return enqueue(T(element));
+}
+
+/*
+ * The element gets the node of a free handle, which is melded with the root.
+ */
+template <typename T, typename Compare, typename KeyFn>
+typename BasicPairingPQHeap<T, Compare, KeyFn>::Handle
+BasicPairingPQHeap<T, Compare, KeyFn>::enqueue(T&& element) {
+    if (_numFilled == _numAllocated) {
+        enlargeSize();
+    }
+    Handle handle = _freeHandles[_numAllocated - _numFilled - 1];
+    _numFilled++;
+    _payloads[handle] = std::move(element);
+    _nodes[handle].key = _key(_payloads[handle]);
+    _nodes[handle].child = NONE;
+    _nodes[handle].sibling = NONE;
+    _nodes[handle].before = NONE;
+    _root = meld(_root, handle);
+    _nodes[_root].before = NONE;
+    return handle;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+template <typename... Args>
+typename BasicPairingPQHeap<T, Compare, KeyFn>::Handle
+BasicPairingPQHeap<T, Compare, KeyFn>::emplace(Args&&... args) {
+    return enqueue(buildElement<T>(std::forward<Args>(args)...));
+}
+
+template <typename T, typename Compare, typename KeyFn>
+T BasicPairingPQHeap<T, Compare, KeyFn>::dequeue() {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    return remove(_root);
+}
+
+template <typename T, typename Compare, typename KeyFn>
+T BasicPairingPQHeap<T, Compare, KeyFn>::remove(Handle handle) {
+    checkHandle(handle);
+    detach(handle);
+    _nodes[handle].before = FREE;
+    _numFilled--;
+    _freeHandles[_numAllocated - _numFilled - 1] = handle;
+    return std::move(_payloads[handle]);
+}
+
+/*
+ * A node that becomes more urgent is cut out with its subtree, which stays in
+ * order, and melded with the root. A node that becomes less urgent may now be
+ * out of order with its children, so it is detached and melded back alone.
+ */
+template <typename T, typename Compare, typename KeyFn>
+void BasicPairingPQHeap<T, Compare, KeyFn>::changePriority(Handle handle, const Key& priority) {
+    checkHandle(handle);
+    _key.set(_payloads[handle], priority);
+    Key key = _key(_payloads[handle]);
+    bool moreUrgent = _compare(key, _nodes[handle].key);
+    _nodes[handle].key = key;
+    if (moreUrgent) {
+        if (handle != _root) {
+            cut(handle);
+            _root = meld(_root, handle);
+            _nodes[_root].before = NONE;
+        }
+    } else {
+        detach(handle);
+        _root = meld(_root, handle);
+        _nodes[_root].before = NONE;
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn>
+const T& BasicPairingPQHeap<T, Compare, KeyFn>::get(Handle handle) const {
+    checkHandle(handle);
+    return _payloads[handle];
+}
+
+template <typename T, typename Compare, typename KeyFn>
+bool BasicPairingPQHeap<T, Compare, KeyFn>::contains(Handle handle) const {
+    return handle >= 0 && handle < _numAllocated && _nodes[handle].before != FREE;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+T BasicPairingPQHeap<T, Compare, KeyFn>::peek() const {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    return _payloads[_root];
+}
+
+template <typename T, typename Compare, typename KeyFn>
+bool BasicPairingPQHeap<T, Compare, KeyFn>::isEmpty() const {
+    return _numFilled == 0;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+int BasicPairingPQHeap<T, Compare, KeyFn>::size() const {
+    return _numFilled;
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicPairingPQHeap<T, Compare, KeyFn>::clear() {
+    _numFilled = 0;
+    _root = NONE;
+    for (int i = 0; i < _numAllocated; i++) {
+        _nodes[i].before = FREE;
+        _freeHandles[i] = _numAllocated - 1 - i;
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicPairingPQHeap<T, Compare, KeyFn>::printDebugInfo(std::string msg) const {
+    std::cout << msg << " (root " << _root << ")" << std::endl;
+    for (int i = 0; i < _numAllocated; i++) {
+        if (contains(i)) {
+            std::cout << "[" << i << "] = " << _nodes[i].key << " child " << _nodes[i].child
+                      << " sibling " << _nodes[i].sibling << " = " << _payloads[i] << std::endl;
+        }
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn>
+void BasicPairingPQHeap<T, Compare, KeyFn>::validateInternalState() const {
+    if (_numFilled > _numAllocated) error("Too many elements in not enough space!");
+    if ((_root == NONE) != (_numFilled == 0)) error("The root does not match the number of elements.");
+    if (_root == NONE) return;
+    if (_nodes[_root].before != NONE || _nodes[_root].sibling != NONE) error("The root has a parent or sibling.");
+
+    Vector<int> toVisit = { _root };
+    int reached = 0;
+    while (!toVisit.isEmpty()) {
+        int parent = toVisit[toVisit.size() - 1];
+        toVisit.remove(toVisit.size() - 1);
+        reached++;
+        Key stored = _key(_payloads[parent]);
+        if (_compare(stored, _nodes[parent].key) || _compare(_nodes[parent].key, stored)) {
+            error("The priority of node " + integerToString(parent) + " does not match its element.");
+        }
+        int before = parent;
+        for (int child = _nodes[parent].child; child != NONE; child = _nodes[child].sibling) {
+            if (reached + toVisit.size() > _numFilled) error("The tree has a cycle or too many nodes.");
+            if (_nodes[child].before != before) {
+                error("The link back from node " + integerToString(child) + " is wrong.");
+            }
+            if (_compare(_nodes[child].key, _nodes[parent].key)) {
+                error("Node " + integerToString(child) + " is more urgent than its parent.");
+            }
+            toVisit.add(child);
+            before = child;
+        }
+    }
+    if (reached != _numFilled) error("Not every queued node is in the tree.");
+}
+
+/**
+ * Priority queue of DataPoints implemented using a pairing heap.
+ */
+using PairingPQHeap = BasicPairingPQHeap<DataPoint, std::less<>, DataPointPriority>;
@@ -0,0 +1,99 @@
+/*
+ * File Synopsis:
+ * The radix heap is a monotone priority queue: no priority enqueued may be smaller than the last one
+ * dequeued. It sorts elements into buckets by the bits of their priorities instead of comparing them.
+ * It is a class template, so its implementation lives in pqradix.h. This file instantiates the DataPoint
+ * queue (RadixPQHeap) and contains its tests; the time trials against the other engines are in pqclient.cpp.
+ */
+
+#include "pqradix.h"
+#include <algorithm>
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include "datapoint.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/* The DataPoint queue is instantiated here so that every member function is compiled
+ * even if no test happens to call it.
+ */
+template class BasicRadixPQHeap<DataPoint, DataPointPriority>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("radixKey: keeps the order of ints, long longs and doubles") {
+    Vector<double> doubles = { -1e300, -5.5, -1, -0.0, 0, 1e-300, 0.25, 3, 1e300 };
+    for (int i = 1; i < doubles.size(); i++) {
+        EXPECT(radixKey(doubles[i - 1]) <= radixKey(doubles[i]));
+    }
+    EXPECT_EQUAL(radixKey(-0.0), radixKey(0.0));
+    EXPECT(radixKey(-3) < radixKey(2));
+    EXPECT(radixKey(-(1LL << 62)) < radixKey(-1LL));
+    EXPECT(radixKey(0u) < radixKey(7u));
+}
+
+STUDENT_TEST("RadixPQHeap: example from writeup, validate each step") {
+    RadixPQHeap pq;
+    Vector<DataPoint> input = {
+        { "R", 4 }, { "A", 5 }, { "B", 3 }, { "K", 7 }, { "G", 2 },
+        { "V", 9 }, { "T", 1 }, { "O", 8 }, { "S", 6 } };
+
+    pq.validateInternalState();
+    for (DataPoint dp : input) {
+        pq.enqueue(dp);
+        pq.validateInternalState();
+    }
+    DataPoint expectedFront = { "T", 1 };
+    EXPECT_EQUAL(pq.peek(), expectedFront);
+    for (int expected = 1; expected <= 9; expected++) {
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+        pq.validateInternalState();
+    }
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peek());
+}
+
+STUDENT_TEST("RadixPQHeap: monotone event simulation, and smaller priorities are rejected") {
+    BasicRadixPQHeap<long long> pq;
+    Vector<long long> dequeued;
+    setRandomSeed(5);
+    for (int i = 0; i < 100; i++) {
+        pq.enqueue(randomInteger(-1000, 1000));
+    }
+    for (int step = 0; step < 5000; step++) {
+        long long now = pq.dequeue();
+        dequeued.add(now);
+        pq.enqueue(now + randomInteger(0, 50));   // each event schedules a later one
+        if (step % 100 == 0) {
+            pq.validateInternalState();
+        }
+    }
+    for (int i = 1; i < dequeued.size(); i++) {
+        EXPECT(dequeued[i - 1] <= dequeued[i]);
+    }
+    EXPECT_ERROR(pq.enqueue(dequeued[dequeued.size() - 1] - 1));
+    EXPECT_EQUAL(pq.size(), 100);
+
+    pq.clear();
+    pq.enqueue(-1000000);   // any priority is allowed again after clear
+    EXPECT_EQUAL(pq.peek(), -1000000);
+}
+
+STUDENT_TEST("RadixPQHeap: matches sorted order for random doubles, ties included") {
+    BasicRadixPQHeap<double> pq;
+    Vector<double> values;
+    setRandomSeed(17);
+    for (int i = 0; i < 2000; i++) {
+        double value = randomInteger(0, 3) == 0 ? 1.5 : randomReal(-1e6, 1e6);
+        values.add(value);
+        pq.enqueue(value);
+    }
+    sort(values.begin(), values.end());
+    for (double expected : values) {
+        EXPECT_EQUAL(pq.peek(), expected);
+        EXPECT_EQUAL(pq.dequeue(), expected);
+    }
+    EXPECT(pq.isEmpty());
+}
@@ -0,0 +1,316 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "strlib.h"
+#include "pqheap.h"
+
+/**
+ * Maps a priority to an unsigned 64-bit integer so that smaller priorities
+ * map to smaller integers. Unsigned integers map to themselves and signed
+ * integers have their sign bit flipped. A double is mapped through its bit
+ * pattern: positive values get the sign bit set and negative values have all
+ * bits flipped, so that comparing the integers agrees with comparing the
+ * doubles (NaN excepted).
+ */
+template <typename Int>
+std::enable_if_t<std::is_integral<Int>::value, uint64_t> radixKey(Int key) {
+    if (std::is_signed<Int>::value) {
+        return uint64_t(int64_t(key)) ^ (uint64_t(1) << 63);
+    }
+    return uint64_t(key);
+}
+
+inline uint64_t radixKey(double key) {
+    if (key == 0) {
+        key = 0; // -0.0 and 0.0 are equal priorities, so they get the same integer
+    }
+    uint64_t bits;
+    std::memcpy(&bits, &key, sizeof(bits));
+    return (bits >> 63) ? ~bits : bits | (uint64_t(1) << 63);
+}
+
+/* Index of the highest set bit of a nonzero 64-bit value. */
+inline int highestSetBit(uint64_t value) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+/**
+ * Monotone priority queue of elements of type T implemented as a radix heap.
+ * The queue is always smallest first, and it is monotone: a new priority may
+ * not be smaller than the priority of the last element dequeued, which is
+ * what event simulations and Dijkstra's algorithm need. Enqueuing a smaller
+ * priority calls error().
+ *
+ * Priorities are mapped to 64-bit integers with radixKey (any integer type or
+ * double). Bucket 0 holds elements whose priority equals the last dequeued
+ * one, and bucket b holds those whose priority first differs from it in bit
+ * b-1. When bucket 0 runs dry, the lowest nonempty bucket is emptied into the
+ * buckets below it around its smallest element, so each element moves at most
+ * 64 times however many are queued: enqueue is O(1) and dequeue is O(1)
+ * amortized, with no comparisons between elements at all.
+ *
+ * KeyFn reads the priority of an element as for BasicPQHeap; there is no
+ * Compare parameter since the order is fixed by the integers.
+ */
+template <typename T, typename KeyFn = IdentityKey>
+class BasicRadixPQHeap {
+public:
+    /**
+     * Creates a new, empty priority queue.
+     */
+    BasicRadixPQHeap() = default;
+
+    /**
+     * Adds a new element into the queue. If its priority is smaller than the
+     * priority of the last element dequeued, this function calls error().
+     *
+     * This operation runs in time O(1).
+     *
+     * @param element The element to add.
+     */
+    void enqueue(const T& element);
+    void enqueue(T&& element);
+
+    /**
+     * Adds a new element into the queue, constructing it from the given
+     * arguments. This operation runs in time O(1).
+     *
+     * @param args The arguments used to brace-initialize the element.
+     */
+    template <typename... Args>
+    void emplace(Args&&... args);
+
+    /**
+     * Removes and returns the element with the smallest priority. If several
+     * share that priority, the order they are dequeued is arbitrary.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in amortized time O(1).
+     *
+     * @return The frontmost element, which is removed from queue.
+     */
+    T dequeue();
+
+    /**
+     * Returns, but does not remove, the element that is frontmost.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(1) unless bucket 0 is empty, in which
+     * case the lowest nonempty bucket is scanned.
+     *
+     * @return frontmost element
+     */
+    T peek() const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const;
+
+    /**
+     * Removes all elements from the priority queue. Afterwards any priority
+     * may be enqueued again.
+     */
+    void clear();
+
+    /*
+     * This function exists purely for testing purposes. It prints how many
+     * elements are in each nonempty bucket.
+     */
+    void printDebugInfo(std::string msg) const;
+
+    /*
+     * This function exits purely for testing purposes. It verifies that every
+     * element is in the bucket its priority belongs to, that none is below the
+     * last dequeued priority, and that the count of elements is right.
+     * If a problem is detected, this function calls error().
+     */
+    void validateInternalState() const;
+
+private:
+    static constexpr int NUM_BUCKETS = 65;
+
+    /* An element together with its priority mapped by radixKey. */
+    struct Entry {
+        uint64_t radix;
+        T element;
+    };
+
+    std::vector<Entry> _buckets[NUM_BUCKETS]; // elements by the highest bit where they differ from _last
+    uint64_t _last = 0;     // radix of the last priority dequeued; no smaller one may be enqueued
+    int _numFilled = 0;     // number of elements in the queue
+    KeyFn _key;             // reads the priority of an element
+
+    int bucketOf(uint64_t radix) const;
+    int lowestNonemptyBucket() const;
+    void refill();          // makes bucket 0 nonempty, redistributing the lowest nonempty bucket
+
+    DISALLOW_COPYING_OF(BasicRadixPQHeap);
+};
+
+/*
+ * Private helper that returns the bucket of a radix: 0 if it equals the last
+ * dequeued radix, else one more than the highest bit in which the two differ.
+ */
+template <typename T, typename KeyFn>
+int BasicRadixPQHeap<T, KeyFn>::bucketOf(uint64_t radix) const {
+    return radix == _last ? 0 : highestSetBit(radix ^ _last) + 1;
+}
+
+template <typename T, typename KeyFn>
+int BasicRadixPQHeap<T, KeyFn>::lowestNonemptyBucket() const {
+    int bucket = 0;
+    while (_buckets[bucket].empty()) {
+        bucket++;
+    }
+    return bucket;
+}
+
+/*
+ * Private helper used by dequeue when bucket 0 is empty. The smallest radix
+ * of the lowest nonempty bucket becomes the new last radix, and every element
+ * of that bucket moves to a strictly lower bucket (at least one to bucket 0).
+ * Elements in higher buckets stay where they are, since they differ from the
+ * new last radix in the same highest bit as from the old one.
+ */
+template <typename T, typename KeyFn>
+void BasicRadixPQHeap<T, KeyFn>::refill() {
+    if (!_buckets[0].empty()) {
+        return;
+    }
+    std::vector<Entry>& source = _buckets[lowestNonemptyBucket()];
+    uint64_t smallest = source[0].radix;
+    for (const Entry& entry : source) {
+        smallest = std::min(smallest, entry.radix);
+    }
+    _last = smallest;
+    for (Entry& entry : source) {
+        _buckets[bucketOf(entry.radix)].push_back(std::move(entry));
+    }
+    source.clear();
+}
+
+template <typename T, typename KeyFn>
+void BasicRadixPQHeap<T, KeyFn>::enqueue(const T& element) {
+    enqueue(T(element));
+}
+
+template <typename T, typename KeyFn>
+void BasicRadixPQHeap<T, KeyFn>::enqueue(T&& element) {
+    uint64_t radix = radixKey(_key(element));
+    if (radix < _last) {
+        error("Radix heap priorities may not be smaller than the last one dequeued");
+    }
+    _buckets[bucketOf(radix)].push_back({ radix, std::move(element) });
+    _numFilled++;
+}
+
+template <typename T, typename KeyFn>
+template <typename... Args>
+void BasicRadixPQHeap<T, KeyFn>::emplace(Args&&... args) {
+    enqueue(buildElement<T>(std::forward<Args>(args)...));
+}
+
+template <typename T, typename KeyFn>
+T BasicRadixPQHeap<T, KeyFn>::dequeue() {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    refill();
+    T front = std::move(_buckets[0].back().element);
+    _buckets[0].pop_back();
+    _numFilled--;
+    return front;
+}
+
+template <typename T, typename KeyFn>
+T BasicRadixPQHeap<T, KeyFn>::peek() const {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    if (!_buckets[0].empty()) {
+        return _buckets[0].back().element;
+    }
+    const std::vector<Entry>& lowest = _buckets[lowestNonemptyBucket()];
+    const Entry* smallest = &lowest[0];
+    for (const Entry& entry : lowest) {
+        if (entry.radix < smallest->radix) {
+            smallest = &entry;
+        }
+    }
+    return smallest->element;
+}
+
+template <typename T, typename KeyFn>
+bool BasicRadixPQHeap<T, KeyFn>::isEmpty() const {
+    return _numFilled == 0;
+}
+
+template <typename T, typename KeyFn>
+int BasicRadixPQHeap<T, KeyFn>::size() const {
+    return _numFilled;
+}
+
+template <typename T, typename KeyFn>
+void BasicRadixPQHeap<T, KeyFn>::clear() {
+    for (std::vector<Entry>& bucket : _buckets) {
+        bucket.clear();
+    }
+    _last = 0;
+    _numFilled = 0;
+}
+
+template <typename T, typename KeyFn>
+void BasicRadixPQHeap<T, KeyFn>::printDebugInfo(std::string msg) const {
+    std::cout << msg << std::endl;
+    for (int b = 0; b < NUM_BUCKETS; b++) {
+        if (!_buckets[b].empty()) {
+            std::cout << "bucket " << b << ": " << _buckets[b].size() << " elements" << std::endl;
+        }
+    }
+}
+
+template <typename T, typename KeyFn>
+void BasicRadixPQHeap<T, KeyFn>::validateInternalState() const {
+    int count = 0;
+    for (int b = 0; b < NUM_BUCKETS; b++) {
+        for (const Entry& entry : _buckets[b]) {
+            if (entry.radix != radixKey(_key(entry.element))) {
+                error("An element in bucket " + integerToString(b) + " does not match its priority.");
+            }
+            if (entry.radix < _last || bucketOf(entry.radix) != b) {
+                error("An element is in bucket " + integerToString(b) + " instead of " + integerToString(bucketOf(entry.radix)) + ".");
+            }
+            count++;
+        }
+    }
+    if (count != _numFilled) error("The count of elements does not match the buckets.");
+}
+
+/**
+ * Monotone priority queue of DataPoints implemented using a radix heap.
+ */
+using RadixPQHeap = BasicRadixPQHeap<DataPoint, DataPointPriority>;
@@ -0,0 +1,38 @@
+#pragma once
+#include <algorithm>
+
+/**
+ * Counts of the work a priority queue has done replacing its array. Both
+ * PQArray and BasicPQHeap keep one of these so that growth and shrink
+ * policies can be compared.
+ */
+struct ResizeStats {
+    long reallocations = 0;  // number of times the array was replaced by a new one
+    long bytesCopied = 0;    // bytes of elements moved from old arrays into new ones
+};
+
+/**
+ * Returns the capacity that an array of the given capacity grows to when it
+ * is full, i.e. capacity times growthFactor, but always at least one slot more.
+ */
+inline int grownCapacity(int capacity, double growthFactor) {
+    return std::max(capacity + 1, int(capacity * growthFactor));
+}
+
+/**
+ * Returns the capacity that an array should shrink to after a dequeue leaves
+ * it holding filled elements, or capacity itself if it should be kept.
+ *
+ * The array shrinks only once it is at most 1/growthFactor^2 full, and then
+ * only to growthFactor times the number of elements, so that it is left
+ * 1/growthFactor full. From there it takes many enqueues to grow again or
+ * many dequeues to shrink again, so a queue whose size goes back and forth
+ * across one boundary does not reallocate on every operation. The array
+ * never shrinks below minCapacity.
+ */
+inline int shrunkCapacity(int filled, int capacity, int minCapacity, double growthFactor) {
+    if (capacity <= minCapacity || filled > capacity / (growthFactor * growthFactor)) {
+        return capacity;
+    }
+    return std::max(minCapacity, int(filled * growthFactor) + 1);
+}
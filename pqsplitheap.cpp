@@ -0,0 +1,133 @@
+/*
+ * File Synopsis:
+ * The split priority queue heap keeps the priorities of its elements in their own dense array, apart from
+ * the elements themselves. It is a class template, so its implementation lives in pqsplitheap.h. This file
+ * instantiates the DataPoint queue (SplitPQHeap) and contains its tests, including a time trial that compares
+ * the memory traffic of the split layout against the array of whole DataPoints used by PQHeap.
+ */
+
+#include "pqsplitheap.h"
+#include "pqheap.h"
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include "datapoint.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/* The DataPoint queue is instantiated here so that every member function is compiled
+ * even if no test happens to call it.
+ */
+template class BasicSplitPQHeap<DataPoint, std::less<>, DataPointPriority>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+/* Helper functions for the time trials: enqueue n random DataPoints, then dequeue n elements. */
+template <typename PQ>
+void fillWithDataPoints(PQ& pq, int n) {
+    for (int i = 0; i < n; i++) {
+        pq.enqueue({ "", randomReal(0, 10) });
+    }
+}
+
+template <typename PQ>
+void drainQueue(PQ& pq, int n) {
+    for (int i = 0; i < n; i++) {
+        pq.dequeue();
+    }
+}
+
+STUDENT_TEST("SplitPQHeap: example from writeup, validate each step") {
+    SplitPQHeap pq;
+    Vector<DataPoint> input = {
+        { "R", 4 }, { "A", 5 }, { "B", 3 }, { "K", 7 }, { "G", 2 },
+        { "V", 9 }, { "T", 1 }, { "O", 8 }, { "S", 6 } };
+
+    pq.validateInternalState();
+    for (DataPoint dp : input) {
+        pq.enqueue(dp);
+        pq.validateInternalState();
+    }
+    EXPECT_EQUAL(pq.peekKey(), 1);
+    for (int expected = 1; expected <= 9; expected++) {
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+        pq.validateInternalState();
+    }
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peek());
+}
+
+STUDENT_TEST("SplitPQHeap: slots are reused across resizing, mixed operations and clear") {
+    BasicSplitPQHeap<DataPoint, less<>, DataPointPriority, 4> pq;
+    setRandomSeed(42);
+    double mostUrgent = 100;
+    for (int i = 0; i < 500; i++) {
+        if (pq.isEmpty() || randomChance(0.7)) {
+            double priority = randomInteger(-20, 20);
+            pq.emplace("name " + integerToString(i), priority);
+            mostUrgent = min(mostUrgent, priority);
+        } else {
+            DataPoint front = pq.dequeue();
+            EXPECT_EQUAL(front.priority, mostUrgent);
+            mostUrgent = pq.isEmpty() ? 100 : pq.peek().priority;
+        }
+        pq.validateInternalState();
+    }
+    pq.clear();
+    pq.validateInternalState();
+    EXPECT(pq.isEmpty());
+    pq.enqueue({ "again", 3 });
+    DataPoint expected = { "again", 3 };
+    EXPECT_EQUAL(pq.peek(), expected);
+}
+
+STUDENT_TEST("mostUrgentKey: vector path agrees with the scalar loop, ties included") {
+    double* keys = allocateAlignedArray<double>(8, 0);
+    auto scalarLess = [](double a, double b) { return a < b; };
+    setRandomSeed(7);
+    for (int trial = 0; trial < 2000; trial++) {
+        for (int i = 0; i < 8; i++) {
+            keys[i] = randomInteger(0, 5); // small range so that ties are common
+        }
+        EXPECT_EQUAL(mostUrgentKey<4>(keys, less<>()), mostUrgentKey<4>(keys, scalarLess));
+        EXPECT_EQUAL(mostUrgentKey<8>(keys, less<>()), mostUrgentKey<8>(keys, scalarLess));
+    }
+    freeAlignedArray(keys, 8, 0);
+}
+
+/* Helper function that runs the dequeue time trial on a keys-only split heap of one arity. */
+template <int Arity>
+void timeSplitDequeueWithArity(int n) {
+    BasicSplitPQHeap<double, less<>, IdentityKey, Arity> pq(n);
+    for (int i = 0; i < n; i++) {
+        pq.enqueue(randomReal(0, 10));
+    }
+    cout << "    arity " << Arity << endl;
+    TIME_OPERATION(n, drainQueue(pq, n));
+}
+
+STUDENT_TEST("SplitPQHeap time trial, dequeue with vector child selection") {
+    cout << "    child selection for full groups of 4 or 8 doubles: " << SPLITHEAP_SIMD << endl;
+    for (int n = 1 << 16; n <= 1 << 22; n <<= 3) {
+        timeSplitDequeueWithArity<2>(n);
+        timeSplitDequeueWithArity<4>(n);
+        timeSplitDequeueWithArity<8>(n);
+    }
+}
+
+STUDENT_TEST("SplitPQHeap time trial, memory traffic versus PQHeap") {
+    // PQHeap sifts whole DataPoints, the split heap sifts a double and an int.
+    cout << "    PQHeap sifts " << sizeof(DataPoint) << " bytes per element, SplitPQHeap sifts "
+         << sizeof(double) + sizeof(int) << endl;
+    for (int n = 1 << 16; n <= 1 << 22; n <<= 3) {
+        PQHeap heap(n);
+        SplitPQHeap split(n);
+        cout << "    PQHeap, " << n * sizeof(DataPoint) / 1024 << " KiB sifted" << endl;
+        TIME_OPERATION(n, fillWithDataPoints(heap, n));
+        TIME_OPERATION(n, drainQueue(heap, n));
+        cout << "    SplitPQHeap, " << n * (sizeof(double) + sizeof(int)) / 1024 << " KiB sifted" << endl;
+        TIME_OPERATION(n, fillWithDataPoints(split, n));
+        TIME_OPERATION(n, drainQueue(split, n));
+    }
+}
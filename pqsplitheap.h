@@ -0,0 +1,543 @@
+#pragma once
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "strlib.h"
+#include "pqheap.h"
+
+/*
+ * The most urgent of a full group of 4 or 8 double priorities can be found
+ * with vector instructions when the heap orders doubles with std::less. The
+ * instruction set is chosen at build time from the compiler's target flags
+ * (AVX when building with -mavx or -mavx2, SSE2 otherwise on x86-64); defining
+ * SPLITHEAP_NO_SIMD forces the scalar loop everywhere.
+ */
+#if !defined(SPLITHEAP_NO_SIMD) && defined(__AVX__)
+#define SPLITHEAP_SIMD "AVX"
+#include <immintrin.h>
+#elif !defined(SPLITHEAP_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#define SPLITHEAP_SIMD "SSE2"
+#include <emmintrin.h>
+#else
+#define SPLITHEAP_SIMD "scalar"
+#endif
+
+/**
+ * Returns the offset of the most urgent of the Count keys starting at keys,
+ * the first one if several are tied. This scalar version works for any key
+ * type and comparator; the loop bound is a constant so it unrolls.
+ */
+template <int Count, typename Key, typename Compare>
+inline int mostUrgentKey(const Key* keys, const Compare& compare) {
+    int best = 0;
+    for (int i = 1; i < Count; i++) {
+        if (compare(keys[i], keys[best])) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+#if !defined(SPLITHEAP_NO_SIMD) && (defined(__AVX__) || defined(__SSE2__) || defined(_M_X64))
+/* Index of the lowest set bit of a nonzero compare mask. */
+inline int lowestSetBit(int mask) {
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    int bit = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+/*
+ * Vector versions for double keys ordered by std::less. Each takes the minimum
+ * across the whole group with a few min instructions, then compares the group
+ * against that minimum to find its first position, with no data-dependent
+ * branches. keys must be aligned to the group size in bytes (or 16 bytes),
+ * which the heap's cache line aligned key array guarantees for full groups of
+ * children. If the minimum matches nothing (a NaN in the group), the scalar
+ * loop decides.
+ */
+#if defined(__AVX__)
+inline __m256d minAcrossLanes(__m256d values) {
+    __m256d halves = _mm256_min_pd(values, _mm256_permute2f128_pd(values, values, 1));
+    return _mm256_min_pd(halves, _mm256_permute_pd(halves, 0x5));
+}
+
+template <>
+inline int mostUrgentKey<4, double, std::less<>>(const double* keys, const std::less<>& compare) {
+    __m256d values = _mm256_load_pd(keys);
+    __m256d minimum = minAcrossLanes(values);
+    int mask = _mm256_movemask_pd(_mm256_cmp_pd(values, minimum, _CMP_EQ_OQ));
+    return mask ? lowestSetBit(mask) : mostUrgentKey<4>(keys, [&](double a, double b) { return compare(a, b); });
+}
+
+template <>
+inline int mostUrgentKey<8, double, std::less<>>(const double* keys, const std::less<>& compare) {
+    __m256d low = _mm256_load_pd(keys);
+    __m256d high = _mm256_load_pd(keys + 4);
+    __m256d minimum = minAcrossLanes(_mm256_min_pd(low, high));
+    int mask = _mm256_movemask_pd(_mm256_cmp_pd(low, minimum, _CMP_EQ_OQ))
+             | _mm256_movemask_pd(_mm256_cmp_pd(high, minimum, _CMP_EQ_OQ)) << 4;
+    return mask ? lowestSetBit(mask) : mostUrgentKey<8>(keys, [&](double a, double b) { return compare(a, b); });
+}
+#else
+inline __m128d minAcrossLanes(__m128d values) {
+    return _mm_min_pd(values, _mm_shuffle_pd(values, values, 1));
+}
+
+template <>
+inline int mostUrgentKey<4, double, std::less<>>(const double* keys, const std::less<>& compare) {
+    __m128d low = _mm_load_pd(keys);
+    __m128d high = _mm_load_pd(keys + 2);
+    __m128d minimum = minAcrossLanes(_mm_min_pd(low, high));
+    int mask = _mm_movemask_pd(_mm_cmpeq_pd(low, minimum))
+             | _mm_movemask_pd(_mm_cmpeq_pd(high, minimum)) << 2;
+    return mask ? lowestSetBit(mask) : mostUrgentKey<4>(keys, [&](double a, double b) { return compare(a, b); });
+}
+
+template <>
+inline int mostUrgentKey<8, double, std::less<>>(const double* keys, const std::less<>& compare) {
+    __m128d v0 = _mm_load_pd(keys);
+    __m128d v1 = _mm_load_pd(keys + 2);
+    __m128d v2 = _mm_load_pd(keys + 4);
+    __m128d v3 = _mm_load_pd(keys + 6);
+    __m128d minimum = minAcrossLanes(_mm_min_pd(_mm_min_pd(v0, v1), _mm_min_pd(v2, v3)));
+    int mask = _mm_movemask_pd(_mm_cmpeq_pd(v0, minimum))
+             | _mm_movemask_pd(_mm_cmpeq_pd(v1, minimum)) << 2
+             | _mm_movemask_pd(_mm_cmpeq_pd(v2, minimum)) << 4
+             | _mm_movemask_pd(_mm_cmpeq_pd(v3, minimum)) << 6;
+    return mask ? lowestSetBit(mask) : mostUrgentKey<8>(keys, [&](double a, double b) { return compare(a, b); });
+}
+#endif
+#endif
+
+/**
+ * Priority queue of elements of type T implemented using a heap that keeps
+ * the priorities apart from the elements (a structure-of-arrays layout).
+ *
+ * The heap itself is a dense, cache line aligned array of priorities (keys)
+ * with a parallel array of slot numbers that say where each element is stored
+ * in a separate payload array. Sifting compares and moves only keys and slot
+ * numbers; an element is written once when it is enqueued and read once when
+ * it is dequeued. For DataPoints, the comparisons on the hot path read 8-byte
+ * doubles instead of 40-byte DataPoints with their strings.
+ *
+ * The template parameters mean the same as for BasicPQHeap, and the public
+ * interface matches it so the two can be swapped for one another.
+ */
+template <typename T, typename Compare = std::less<>, typename KeyFn = IdentityKey, int Arity = 2>
+class BasicSplitPQHeap {
+    static_assert(Arity >= 2, "A heap node needs at least two children");
+
+public:
+    /* The type of priority that KeyFn reads from an element. */
+    using Key = std::decay_t<decltype(std::declval<KeyFn>()(std::declval<const T&>()))>;
+
+    /**
+     * Creates a new, empty priority queue.
+     */
+    BasicSplitPQHeap();
+
+    /**
+     * Creates a new, empty priority queue with room for capacity elements
+     * allocated up front.
+     *
+     * @param capacity The number of slots to allocate.
+     */
+    BasicSplitPQHeap(int capacity);
+
+    /**
+     * Cleans up all memory allocated by this priority queue.
+     */
+    ~BasicSplitPQHeap();
+
+    /**
+     * Adds a new element into the queue. This operation runs in time O(log n),
+     * where n is the number of elements in the queue.
+     *
+     * @param element The element to add.
+     */
+    void enqueue(const T& element);
+    void enqueue(T&& element);
+
+    /**
+     * Adds a new element into the queue, constructing it from the given
+     * arguments. This operation runs in time O(log n).
+     *
+     * @param args The arguments used to brace-initialize the element.
+     */
+    template <typename... Args>
+    void emplace(Args&&... args);
+
+    /**
+     * Removes and returns the element that is frontmost in this priority queue.
+     * If the priority queue contains two or more elements of equal priority,
+     * the order those elements are dequeued is arbitrary.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(log n).
+     *
+     * @return The frontmost element, which is removed from queue.
+     */
+    T dequeue();
+
+    /**
+     * Returns, but does not remove, the element that is frontmost.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(1).
+     *
+     * @return frontmost element
+     */
+    T peek() const;
+
+    /**
+     * Returns the priority of the frontmost element without touching the
+     * element itself.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(1).
+     *
+     * @return priority of the frontmost element
+     */
+    Key peekKey() const;
+
+    /**
+     * Returns whether this priority queue is empty.
+     *
+     * This operation runs in time O(1).
+     *
+     * @return true if contains no elements, false otherwise.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Returns the count of elements in this priority queue.
+     *
+     * This operation runs in time O(1).
+     *
+     * @return The count of elements in the priority queue.
+     */
+    int size() const;
+
+    /**
+     * Removes all elements from the priority queue.
+     *
+     * This operation runs in time O(capacity) since every payload slot is
+     * marked free again.
+     */
+    void clear();
+
+    /*
+     * This function exists purely for testing purposes. It prints the heap of
+     * priorities along with the element each one refers to.
+     */
+    void printDebugInfo(std::string msg) const;
+
+    /*
+     * This function exits purely for testing purposes. It verifies
+     * that the internal state of the queue is valid/consistent.
+     * If a problem is detected, this function calls error().
+     * If no problem, the function returns normally.
+     */
+    void validateInternalState() const;
+
+private:
+    static constexpr int INITIAL_CAPACITY = 10;
+    static constexpr int PADDING = Arity - 1; // unused slots in front of index 0 that align each group of children
+
+    Key* _keys;             // heap of priorities
+    int* _slots;            // _slots[i] is the payload slot of the element whose priority is _keys[i]
+    T* _payloads;           // elements, each in the slot that was free when it was enqueued
+    int* _freeSlots;        // stack of unused payload slots, _numAllocated - _numFilled of them
+    int _numAllocated;      // number of slots allocated in each array
+    int _numFilled;         // number of elements in the queue
+
+    Compare _compare;       // orders two priorities, true if the first is more urgent
+    KeyFn _key;             // reads the priority of an element
+
+    void allocateArrays(int capacity);
+    void freeArrays();
+    void enlargeSize();
+    void siftUp(int index);
+    void siftDown(int index);
+
+    DISALLOW_COPYING_OF(BasicSplitPQHeap);
+};
+
+/*
+ * The allocators size every array for the given number of elements and mark
+ * every payload slot as free.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+BasicSplitPQHeap<T, Compare, KeyFn, Arity>::BasicSplitPQHeap() {
+    allocateArrays(INITIAL_CAPACITY);
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+BasicSplitPQHeap<T, Compare, KeyFn, Arity>::BasicSplitPQHeap(int capacity) {
+    allocateArrays(std::max(capacity, 1));
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+BasicSplitPQHeap<T, Compare, KeyFn, Arity>::~BasicSplitPQHeap() {
+    freeArrays();
+}
+
+/*
+ * Private helper that allocates all four arrays with room for capacity
+ * elements. The key heap gets the same cache line alignment as BasicPQHeap.
+ * The free stack is filled so that slot 0 is handed out first.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicSplitPQHeap<T, Compare, KeyFn, Arity>::allocateArrays(int capacity) {
+    _numAllocated = capacity;
+    _numFilled = 0;
+    _keys = allocateAlignedArray<Key>(capacity, PADDING);
+    _slots = new int[capacity];
+    _payloads = new T[capacity]();
+    _freeSlots = new int[capacity];
+    for (int i = 0; i < capacity; i++) {
+        _freeSlots[i] = capacity - 1 - i;
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicSplitPQHeap<T, Compare, KeyFn, Arity>::freeArrays() {
+    freeAlignedArray(_keys, _numAllocated, PADDING);
+    delete[] _slots;
+    delete[] _payloads;
+    delete[] _freeSlots;
+}
+
+/*
+ * Private helper that doubles every array. It is only called when the queue
+ * is full, so there are no free slots to carry over; the new free stack holds
+ * exactly the slots past the old capacity.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicSplitPQHeap<T, Compare, KeyFn, Arity>::enlargeSize() {
+    int newAllocated = _numAllocated * 2;
+    Key* newKeys = allocateAlignedArray<Key>(newAllocated, PADDING);
+    int* newSlots = new int[newAllocated];
+    T* newPayloads = new T[newAllocated]();
+    int* newFreeSlots = new int[newAllocated];
+    for (int i = 0; i < _numFilled; i++) {
+        newKeys[i] = _keys[i];
+        newSlots[i] = _slots[i];
+    }
+    for (int i = 0; i < _numAllocated; i++) {
+        newPayloads[i] = std::move(_payloads[i]);
+    }
+    for (int i = 0; i < newAllocated - _numAllocated; i++) {
+        newFreeSlots[i] = newAllocated - 1 - i;
+    }
+    freeArrays();
+    _keys = newKeys;
+    _slots = newSlots;
+    _payloads = newPayloads;
+    _freeSlots = newFreeSlots;
+    _numAllocated = newAllocated;
+}
+
+/*
+ * Private helper, the hole-based sift up of siftUp in pqheap.h applied to the
+ * parallel key and slot arrays. Only keys are compared.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicSplitPQHeap<T, Compare, KeyFn, Arity>::siftUp(int index) {
+    Key movingKey = _keys[index];
+    int movingSlot = _slots[index];
+    while (index > 0) {
+        int parent = (index - 1) / Arity;
+        if (!_compare(movingKey, _keys[parent])) {
+            break;
+        }
+        _keys[index] = _keys[parent];
+        _slots[index] = _slots[parent];
+        index = parent;
+    }
+    _keys[index] = movingKey;
+    _slots[index] = movingSlot;
+}
+
+/*
+ * Private helper, the hole-based sift down of siftDown in pqheap.h applied to
+ * the parallel key and slot arrays. Choosing the most urgent child reads only
+ * the dense key array. A node with all Arity children picks the most urgent
+ * with mostUrgentKey, which is a single vector compare-and-reduce for 4 or 8
+ * double keys; only the last, partly filled group uses the plain loop.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicSplitPQHeap<T, Compare, KeyFn, Arity>::siftDown(int index) {
+    Key movingKey = _keys[index];
+    int movingSlot = _slots[index];
+    int firstChild = Arity * index + 1;
+    while (firstChild < _numFilled) {
+        int best = firstChild;
+        if (firstChild + Arity <= _numFilled) {
+            best += mostUrgentKey<Arity>(_keys + firstChild, _compare);
+        } else {
+            for (int child = firstChild + 1; child < _numFilled; child++) {
+                if (_compare(_keys[child], _keys[best])) {
+                    best = child;
+                }
+            }
+        }
+        if (!_compare(_keys[best], movingKey)) {
+            break;
+        }
+        _keys[index] = _keys[best];
+        _slots[index] = _slots[best];
+        index = best;
+        firstChild = Arity * index + 1;
+    }
+    _keys[index] = movingKey;
+    _slots[index] = movingSlot;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicSplitPQHeap<T, Compare, KeyFn, Arity>::enqueue(const T& element) {
+    enqueue(T(element));
+}
+
+/*
+ * The element is moved into a free payload slot, which it keeps until it is
+ * dequeued; only its priority and slot number take part in the sift up.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicSplitPQHeap<T, Compare, KeyFn, Arity>::enqueue(T&& element) {
+    if (_numFilled == _numAllocated) {
+        enlargeSize();
+    }
+    int slot = _freeSlots[_numAllocated - _numFilled - 1];
+    _keys[_numFilled] = _key(element);
+    _slots[_numFilled] = slot;
+    _payloads[slot] = std::move(element);
+    siftUp(_numFilled);
+    _numFilled++;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+template <typename... Args>
+void BasicSplitPQHeap<T, Compare, KeyFn, Arity>::emplace(Args&&... args) {
+    enqueue(buildElement<T>(std::forward<Args>(args)...));
+}
+
+/*
+ * The frontmost element is moved out of its payload slot and the slot is
+ * pushed back on the free stack before the last key is sifted down from the
+ * root.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+T BasicSplitPQHeap<T, Compare, KeyFn, Arity>::dequeue() {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    int slot = _slots[0];
+    T front = std::move(_payloads[slot]);
+    _numFilled--;
+    _freeSlots[_numAllocated - _numFilled - 1] = slot;
+    if (_numFilled > 0) {
+        _keys[0] = _keys[_numFilled];
+        _slots[0] = _slots[_numFilled];
+        siftDown(0);
+    }
+    return front;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+T BasicSplitPQHeap<T, Compare, KeyFn, Arity>::peek() const {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    return _payloads[_slots[0]];
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+typename BasicSplitPQHeap<T, Compare, KeyFn, Arity>::Key BasicSplitPQHeap<T, Compare, KeyFn, Arity>::peekKey() const {
+    if (isEmpty()) {
+        error("PQueue is empty!");
+    }
+    return _keys[0];
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+bool BasicSplitPQHeap<T, Compare, KeyFn, Arity>::isEmpty() const {
+    return _numFilled == 0;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+int BasicSplitPQHeap<T, Compare, KeyFn, Arity>::size() const {
+    return _numFilled;
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicSplitPQHeap<T, Compare, KeyFn, Arity>::clear() {
+    _numFilled = 0;
+    for (int i = 0; i < _numAllocated; i++) {
+        _freeSlots[i] = _numAllocated - 1 - i;
+    }
+}
+
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicSplitPQHeap<T, Compare, KeyFn, Arity>::printDebugInfo(std::string msg) const {
+    std::cout << msg << std::endl;
+    for (int i = 0; i < size(); i++) {
+        std::cout << "[" << i << "] = " << _keys[i] << " -> slot " << _slots[i] << " = " << _payloads[_slots[i]] << std::endl;
+    }
+}
+
+/*
+ * Checks the heap order of the keys, that every key matches the element in its
+ * slot, and that no slot is used twice or is both used and free.
+ */
+template <typename T, typename Compare, typename KeyFn, int Arity>
+void BasicSplitPQHeap<T, Compare, KeyFn, Arity>::validateInternalState() const {
+    if (_numFilled > _numAllocated) error("Too many elements in not enough space!");
+
+    int* owners = new int[_numAllocated];
+    for (int i = 0; i < _numAllocated; i++) {
+        owners[i] = 0;
+    }
+    for (int i = 0; i < _numAllocated - _numFilled; i++) {
+        owners[_freeSlots[i]]++;
+    }
+    for (int i = 0; i < _numFilled; i++) {
+        owners[_slots[i]]++;
+    }
+    for (int i = 0; i < _numAllocated; i++) {
+        if (owners[i] != 1) {
+            delete[] owners;
+            error("Payload slot " + integerToString(i) + " is used or freed more than once.");
+        }
+    }
+    delete[] owners;
+
+    for (int i = 0; i < _numFilled; i++) {
+        if (_compare(_key(_payloads[_slots[i]]), _keys[i]) || _compare(_keys[i], _key(_payloads[_slots[i]]))) {
+            error("The priority at index " + integerToString(i) + " does not match its element.");
+        }
+        if (i > 0 && _compare(_keys[i], _keys[(i - 1) / Arity])) {
+            error("The priority of index " + integerToString(i) + " has an incorrect priority relationship to its parent.");
+        }
+    }
+}
+
+/**
+ * Priority queue of DataPoints whose priorities are kept in their own array.
+ */
+using SplitPQHeap = BasicSplitPQHeap<DataPoint, std::less<>, DataPointPriority>;
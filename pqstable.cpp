@@ -0,0 +1,95 @@
+/*
+ * File Synopsis:
+ * The stable heap is a PQHeap whose elements carry the sequence number of their enqueue, packed with
+ * the priority into one key, so that equal priorities come out first in, first out. It is a class
+ * template, so its implementation lives in pqstable.h. This file instantiates the DataPoint queue
+ * (StablePQHeap) and contains its tests; the time trial against PQHeap is in pqclient.cpp.
+ */
+
+#include "pqstable.h"
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include "datapoint.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/* The DataPoint queue is instantiated here so that every member function is compiled
+ * even if no test happens to call it.
+ */
+template class BasicStablePQHeap<DataPoint, std::less<>, DataPointPriority>;
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("packStableKey: orders by priority first, then by sequence") {
+    EXPECT(packStableKey(radixKey(1.0), 99) < packStableKey(radixKey(2.0), 0));
+    EXPECT(packStableKey(radixKey(-5.0), 7) < packStableKey(radixKey(-5.0), 8));
+    EXPECT(!(packStableKey(radixKey(3.0), 8) < packStableKey(radixKey(3.0), 7)));
+    EXPECT_EQUAL(stableKeyPriority(packStableKey(12345, 6)), 12345);
+    EXPECT_EQUAL(stableKeySequence(packStableKey(12345, 6)), 6);
+}
+
+STUDENT_TEST("StablePQHeap: example from writeup, validate each step") {
+    StablePQHeap pq;
+    Vector<DataPoint> input = {
+        { "R", 4 }, { "A", 5 }, { "B", 3 }, { "K", 7 }, { "G", 2 },
+        { "V", 9 }, { "T", 1 }, { "O", 8 }, { "S", 6 } };
+
+    pq.validateInternalState();
+    for (DataPoint dp : input) {
+        pq.enqueue(dp);
+        pq.validateInternalState();
+    }
+    DataPoint expectedFront = { "T", 1 };
+    EXPECT_EQUAL(pq.peek(), expectedFront);
+    for (int expected = 1; expected <= 9; expected++) {
+        EXPECT_EQUAL(pq.dequeue().priority, expected);
+        pq.validateInternalState();
+    }
+    EXPECT_ERROR(pq.dequeue());
+    EXPECT_ERROR(pq.peek());
+}
+
+STUDENT_TEST("StablePQHeap: equal priorities dequeue first in, first out under interleaving") {
+    StablePQHeap pq;
+    Vector<DataPoint> waiting;      // queued jobs in the order they were enqueued
+    setRandomSeed(8);
+    for (int i = 0; i < 3000; i++) {
+        if (waiting.isEmpty() || randomChance(0.6)) {
+            DataPoint job = { "job " + integerToString(i), double(randomInteger(1, 5)) };
+            pq.enqueue(job);
+            waiting.add(job);
+        } else {
+            int oldestMostUrgent = 0;  // the first of the jobs with the smallest priority
+            for (int j = 1; j < waiting.size(); j++) {
+                if (waiting[j].priority < waiting[oldestMostUrgent].priority) {
+                    oldestMostUrgent = j;
+                }
+            }
+            EXPECT_EQUAL(pq.dequeue(), waiting[oldestMostUrgent]);
+            waiting.remove(oldestMostUrgent);
+        }
+        if (i % 100 == 0) {
+            pq.validateInternalState();
+        }
+    }
+    EXPECT_EQUAL(pq.size(), waiting.size());
+    pq.clear();
+    EXPECT(pq.isEmpty());
+}
+
+STUDENT_TEST("BasicStablePQHeap: largest first, ties still first in, first out") {
+    BasicStablePQHeap<DataPoint, greater<>, DataPointPriority, 4> pq;
+    for (int i = 0; i < 100; i++) {
+        pq.emplace(integerToString(i), double(i % 3));
+    }
+    pq.validateInternalState();
+    for (int priority = 2; priority >= 0; priority--) {
+        for (int i = priority; i < 100; i += 3) {
+            DataPoint expected = { integerToString(i), double(priority) };
+            EXPECT_EQUAL(pq.dequeue(), expected);
+        }
+    }
+    EXPECT(pq.isEmpty());
+}
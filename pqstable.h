@@ -0,0 +1,242 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "error.h"
+#include "pqheap.h"
+#include "pqradix.h"
+
+/**
+ * The packed key of the stable heap: the priority mapped to 64 bits by
+ * radixKey in the high half and the sequence number of the enqueue in the
+ * low half, so one unsigned comparison orders by priority and then by age.
+ * Compilers with a 128-bit integer type compare it in two instructions;
+ * elsewhere a pair of 64-bit words stands in.
+ */
+#if defined(__SIZEOF_INT128__)
+using StableKey = unsigned __int128;
+
+inline StableKey packStableKey(uint64_t priority, uint64_t sequence) {
+    return (StableKey(priority) << 64) | sequence;
+}
+
+inline uint64_t stableKeyPriority(StableKey key) {
+    return uint64_t(key >> 64);
+}
+
+inline uint64_t stableKeySequence(StableKey key) {
+    return uint64_t(key);
+}
+#else
+struct StableKey {
+    uint64_t high;
+    uint64_t low;
+
+    bool operator<(const StableKey& other) const {
+        return high != other.high ? high < other.high : low < other.low;
+    }
+};
+
+inline StableKey packStableKey(uint64_t priority, uint64_t sequence) {
+    return { priority, sequence };
+}
+
+inline uint64_t stableKeyPriority(StableKey key) {
+    return key.high;
+}
+
+inline uint64_t stableKeySequence(StableKey key) {
+    return key.low;
+}
+#endif
+
+/**
+ * An element of the stable heap together with its packed key.
+ */
+template <typename T>
+struct StampedElement {
+    StableKey key;
+    T element;
+};
+
+template <typename T>
+std::ostream& operator<<(std::ostream& out, const StampedElement<T>& stamped) {
+    return out << stamped.element << " #" << stableKeySequence(stamped.key);
+}
+
+/**
+ * Key function that reads the packed key of a StampedElement.
+ */
+struct StampedKey {
+    template <typename T>
+    const StableKey& operator()(const StampedElement<T>& stamped) const {
+        return stamped.key;
+    }
+};
+
+/**
+ * Priority queue of elements of type T in which elements of equal priority
+ * are dequeued in the order they were enqueued (first in, first out), where
+ * BasicPQHeap leaves that order arbitrary.
+ *
+ * Every enqueue stamps the element with the next number of a 64-bit counter
+ * and packs its priority and that number into one StableKey, so the heap
+ * still does a single key comparison per step. The price is the 16-byte key
+ * stored beside each element.
+ *
+ * KeyFn reads the priority of an element as for BasicPQHeap; it must be an
+ * integer type or double, as for radixKey. Compare is std::less<> (smallest
+ * first) or std::greater<> (largest first); ties are first in, first out
+ * either way. The template parameters are in the same order as BasicPQHeap's.
+ */
+template <typename T, typename Compare = std::less<>, typename KeyFn = IdentityKey, int Arity = 2>
+class BasicStablePQHeap {
+    static_assert(std::is_same<Compare, std::less<>>::value || std::is_same<Compare, std::greater<>>::value,
+                  "A stable heap orders by std::less<> or std::greater<>");
+
+public:
+    /**
+     * Creates a new, empty priority queue.
+     */
+    BasicStablePQHeap() = default;
+
+    /**
+     * Creates a new, empty priority queue with room for capacity elements
+     * allocated up front.
+     *
+     * @param capacity The number of slots to allocate.
+     */
+    BasicStablePQHeap(int capacity) : _heap(capacity) {}
+
+    /**
+     * Adds a new element into the queue behind every element already queued
+     * with the same priority. This operation runs in time O(log n).
+     *
+     * @param element The element to add.
+     */
+    void enqueue(const T& element) {
+        enqueue(T(element));
+    }
+
+    void enqueue(T&& element) {
+        StableKey key = packStableKey(orderedPriority(element), _nextSequence++);
+        _heap.enqueue({ key, std::move(element) });
+    }
+
+    /**
+     * Adds a new element into the queue, constructing it from the given
+     * arguments. This operation runs in time O(log n).
+     *
+     * @param args The arguments used to brace-initialize the element.
+     */
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        enqueue(buildElement<T>(std::forward<Args>(args)...));
+    }
+
+    /**
+     * Removes and returns the element that is frontmost in this priority
+     * queue. Of several elements with the frontmost priority, the one that
+     * was enqueued first is returned.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * This operation runs in time O(log n).
+     *
+     * @return The frontmost element, which is removed from queue.
+     */
+    T dequeue() {
+        return _heap.dequeue().element;
+    }
+
+    /**
+     * Returns, but does not remove, the element that is frontmost.
+     *
+     * If the priority queue is empty, this function calls error().
+     *
+     * @return frontmost element
+     */
+    T peek() const {
+        return _heap.peek().element;
+    }
+
+    /**
+     * Returns whether this priority queue is empty.
+     */
+    bool isEmpty() const {
+        return _heap.isEmpty();
+    }
+
+    /**
+     * Returns the count of elements in this priority queue.
+     */
+    int size() const {
+        return _heap.size();
+    }
+
+    /**
+     * Removes all elements from the priority queue and restarts the sequence
+     * numbers.
+     */
+    void clear() {
+        _heap.clear();
+        _nextSequence = 0;
+    }
+
+    /**
+     * Makes sure the array has room for at least capacity elements.
+     *
+     * @param capacity The number of elements to make room for.
+     */
+    void reserve(int capacity) {
+        _heap.reserve(capacity);
+    }
+
+    /*
+     * This function exists purely for testing purposes. It prints the heap
+     * array, each element followed by its packed key.
+     */
+    void printDebugInfo(std::string msg) const {
+        _heap.printDebugInfo(msg);
+    }
+
+    /*
+     * This function exits purely for testing purposes. It verifies that the
+     * heap is in order by packed key and that the front's key holds its
+     * priority. If a problem is detected, this function calls error().
+     */
+    void validateInternalState() const {
+        _heap.validateInternalState();
+        if (!isEmpty() && stableKeyPriority(_heap.peek().key) != orderedPriority(_heap.peek().element)) {
+            error("The key of the front element does not match its priority.");
+        }
+        if (uint64_t(size()) > _nextSequence) {
+            error("More elements are queued than sequence numbers were handed out.");
+        }
+    }
+
+private:
+    BasicPQHeap<StampedElement<T>, std::less<>, StampedKey, Arity> _heap;
+    uint64_t _nextSequence = 0; // sequence number of the next enqueue
+    KeyFn _key;                 // reads the priority of an element
+
+    /* The priority mapped so that more urgent is smaller: radixKey for
+     * smallest first, its complement for largest first. */
+    uint64_t orderedPriority(const T& element) const {
+        uint64_t radix = radixKey(_key(element));
+        return std::is_same<Compare, std::greater<>>::value ? ~radix : radix;
+    }
+
+    DISALLOW_COPYING_OF(BasicStablePQHeap);
+};
+
+/**
+ * Priority queue of DataPoints, smallest priority first, in which equal
+ * priorities are dequeued first in, first out.
+ */
+using StablePQHeap = BasicStablePQHeap<DataPoint, std::less<>, DataPointPriority>;